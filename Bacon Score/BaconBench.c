@@ -0,0 +1,256 @@
+/*
+* File: BaconBench.c
+* Author: Chance Krueger
+*
+* Purpose:
+*   Measures how the Bacon graph library scales. For every movies file named
+*   on the command line (usually files of growing size from BaconGenerate) it
+*   prints one line with the parse throughput, the graph build time, the time
+*   of one full BFS, latency percentiles of random pair searches and the peak
+*   resident set size.
+*
+*   Each file is measured in a child process of its own, so its peak memory is
+*   not hidden by a larger file measured before it.
+*/
+
+
+
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "bacon_internal.h"
+#include "bacon_random.h"
+
+
+
+// Random pair searches timed per file unless --queries says otherwise
+#define DEFAULT_QUERIES 1000
+
+
+
+/*
+* compareDoubles(a, b) -- orders two latencies for qsort.
+* a: pointer to the first double.
+* b: pointer to the second double.
+* Returns: negative, zero or positive as *a is smaller than, equal to or larger than *b.
+* Assumptions: none.
+* Side effects: none.
+*/
+int compareDoubles(const void *a, const void *b) {
+
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+
+
+/*
+* percentile(sorted, count, fraction) -- picks a percentile from sorted samples.
+* sorted: array of samples in increasing order.
+* count: number of samples, at least 1.
+* fraction: the percentile as a fraction, e.g. 0.99.
+* Returns: the smallest sample no fewer than fraction of all samples are at or below.
+* Assumptions: none.
+* Side effects: none.
+*/
+double percentile(const double *sorted, size_t count, double fraction) {
+
+	size_t rank = (size_t) (fraction * count + 0.999999);
+
+	if (rank < 1) {
+		rank = 1;
+	}
+	if (rank > count) {
+		rank = count;
+	}
+	return sorted[rank - 1];
+}
+
+
+
+/*
+* benchmarkFile(path, threads, queries) -- loads one movies file and prints its measurements.
+* path: pointer to a string containing the file's path.
+* threads: thread count for parsing and the full BFS (0 = one per online CPU).
+* queries: number of random pair searches to time.
+* Returns: 0 on success, 1 if the file could not be opened.
+* Assumptions: meant to run in a process of its own, which it leaves at its peak
+*              memory use.
+* Side effects: writes one result line to stdout.
+*/
+int benchmarkFile(const char *path, long threads, size_t queries) {
+
+	struct bacon_graph *g = calloc(1, sizeof(struct bacon_graph));
+
+	if (g == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	g->threads = threads;
+	g->snapshotCenter = NO_ACTOR;
+
+	double start = clockSeconds();
+
+	if (loadInput(g, path) != 0) {
+		fprintf(stderr, "Could not Open %s.\n", path);
+		free(g);
+		return 1;
+	}
+	pthread_mutex_init(&g->foldLock, NULL);
+	pthread_mutex_init(&g->bfsLock, NULL);
+	parseFile(g);
+
+	double parsed = clockSeconds();
+
+	buildGraph(g);
+	labelComponents(g);
+
+	double built = clockSeconds();
+
+	struct searchState forward;
+	struct searchState backward;
+
+	initSearchState(g, &forward);
+	initSearchState(g, &backward);
+
+	// One full search from Kevin Bacon (or from actor 0 when he is not in the file)
+	uint32_t numActors = g->csr.numActors;
+	uint32_t center = findActor(g, "Kevin Bacon", strlen("Kevin Bacon"));
+	int *distances = malloc(((size_t) numActors + 1) * sizeof(int));
+	uint32_t *parents = malloc(((size_t) numActors + 1) * sizeof(uint32_t));
+	uint32_t *parentMovies = malloc(((size_t) numActors + 1) * sizeof(uint32_t));
+	double *latencies = malloc((queries + 1) * sizeof(double));
+
+	if (distances == NULL || parents == NULL || parentMovies == NULL || latencies == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	double fullTime = 0;
+
+	if (numActors > 0) {
+		double fullStart = clockSeconds();
+		BFSAll(&forward, center != NO_ACTOR ? center : 0, distances, parents, parentMovies);
+		fullTime = clockSeconds() - fullStart;
+	}
+
+	// Pair searches between random actors; the seed is fixed so runs compare
+	uint64_t seed = 1;
+	size_t timed = 0;
+
+	for (size_t index = 0; index < queries && numActors > 0; index++) {
+		uint32_t from = nextRandom(&seed) % numActors;
+		uint32_t to = nextRandom(&seed) % numActors;
+		uint32_t meet;
+
+		double queryStart = clockSeconds();
+		BFS(&forward, &backward, from, to, &meet);
+		latencies[timed++] = clockSeconds() - queryStart;
+	}
+	qsort(latencies, timed, sizeof(double), compareDoubles);
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	double parseTime = parsed - start;
+	double megabytes = g->nameBaseSize / (double) (1 << 20);
+
+	printf("%-24s %9.1f %10u %10u %11u %8.3f %8.1f %8.3f %9.2f",
+		path, megabytes, g->csr.numActors, g->csr.numMovies, g->csr.numEdges,
+		parseTime, parseTime > 0 ? megabytes / parseTime : 0.0, built - parsed, fullTime * 1e3);
+	if (timed > 0) {
+		printf(" %9.1f %9.1f %9.1f %9.1f",
+			percentile(latencies, timed, 0.50) * 1e6, percentile(latencies, timed, 0.90) * 1e6,
+			percentile(latencies, timed, 0.99) * 1e6, latencies[timed - 1] * 1e6);
+	} else {
+		printf(" %9s %9s %9s %9s", "-", "-", "-", "-");
+	}
+	printf(" %8.1f\n", usage.ru_maxrss / 1024.0);
+
+	free(latencies);
+	free(distances);
+	free(parents);
+	free(parentMovies);
+	freeSearchState(&forward);
+	freeSearchState(&backward);
+	bacon_close(g);
+	return 0;
+}
+
+
+
+/*
+* main(argc, argv) -- benchmarks every movies file given on the command line.
+* argc: integer representing the number of command-line arguments.
+* argv: array of strings: optional --threads N and --queries N, then the files.
+* Returns: 0 if every file was measured, 1 otherwise.
+* Assumptions: none.
+* Side effects: forks one child per file and writes a table to stdout.
+*/
+int main(int argc, char* argv[]) {
+
+	long threads = 0;
+	long queries = DEFAULT_QUERIES;
+	int first = 1;
+
+	while (first < argc && strncmp(argv[first], "--", 2) == 0) {
+		if (strcmp("--threads", argv[first]) == 0) {
+			if (first + 1 == argc || (threads = strtol(argv[first + 1], NULL, 10)) < 1) {
+				fprintf(stderr, "Invalid Thread Count.\n");
+				return 1;
+			}
+		} else if (strcmp("--queries", argv[first]) == 0) {
+			if (first + 1 == argc || (queries = strtol(argv[first + 1], NULL, 10)) < 0) {
+				fprintf(stderr, "Invalid Query Count.\n");
+				return 1;
+			}
+		} else {
+			fprintf(stderr, "Unknown Option %s.\n", argv[first]);
+			return 1;
+		}
+		first += 2;
+	}
+
+	if (first == argc) {
+		fprintf(stderr, "Usage: %s [--threads N] [--queries N] inputFile...\n", argv[0]);
+		return 1;
+	}
+
+	printf("%-24s %9s %10s %10s %11s %8s %8s %8s %9s %9s %9s %9s %9s %8s\n",
+		"file", "MiB", "actors", "movies", "edges", "parse_s", "MiB/s", "build_s",
+		"full_ms", "p50_us", "p90_us", "p99_us", "max_us", "rss_MiB");
+	fflush(stdout);
+
+	int errSeen = 0;
+
+	for (int index = first; index < argc; index++) {
+		pid_t child = fork();
+
+		if (child < 0) {
+			fprintf(stderr, "Could not Start a Process for %s.\n", argv[index]);
+			errSeen = 1;
+			continue;
+		}
+		if (child == 0) {
+			int result = benchmarkFile(argv[index], threads, queries);
+			fflush(stdout);
+			_exit(result);
+		}
+
+		int status;
+
+		if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			errSeen = 1;
+		}
+	}
+	return errSeen;
+}
@@ -0,0 +1,163 @@
+/*
+* File: BaconGenerate.c
+* Author: Chance Krueger
+*
+* Purpose:
+*   Writes a synthetic movies file in the same "Movie:" format as movies.txt,
+*   so that parsing and searching can be measured on graphs of any size.
+*
+*   Real casting is heavily skewed, and the generator imitates that: cast
+*   sizes follow a Pareto distribution (most films have a handful of credited
+*   actors, a few have hundreds), and a few popular actors take a large share
+*   of all roles. Actor 0 is always "Kevin Bacon" and the most popular of all,
+*   so every generated file has a well-connected center.
+*
+*   The output only depends on the appearance count and the seed.
+*/
+
+
+
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "bacon_random.h"
+
+
+
+// Cast sizes: Pareto with this shape and minimum, capped at MAX_CAST
+#define CAST_SHAPE 1.6
+#define MIN_CAST 2
+#define MAX_CAST 1000
+
+// Actor picks: ID = numActors * u^ACTOR_SKEW for uniform u, so low IDs are popular
+#define ACTOR_SKEW 2.0
+
+// Average appearances per actor, which decides how many actors there are
+#define APPEARANCES_PER_ACTOR 4
+
+// Picks after which a movie gives up on finding another actor not yet in its cast
+#define MAX_RETRIES 64
+
+
+
+/*
+* nextUniform(state) -- draws a uniform number from a splitmix64 generator.
+* state: pointer to the generator state.
+* Returns: a double in [0, 1).
+* Assumptions: none.
+* Side effects: updates *state.
+*/
+double nextUniform(uint64_t *state) {
+	return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+
+/*
+* castSize(state) -- draws the number of actors in a movie.
+* state: pointer to the generator state.
+* Returns: a cast size between MIN_CAST and MAX_CAST.
+* Assumptions: none.
+* Side effects: updates *state.
+*/
+uint32_t castSize(uint64_t *state) {
+
+	double size = MIN_CAST * pow(1.0 - nextUniform(state), -1.0 / CAST_SHAPE);
+
+	return size >= MAX_CAST ? MAX_CAST : (uint32_t) size;
+}
+
+
+
+/*
+* printActor(out, actor) -- writes one actor line.
+* out: pointer to the output stream.
+* actor: ID of the actor.
+* Returns: void.
+* Assumptions: none.
+* Side effects: writes to out.
+*/
+void printActor(FILE *out, uint32_t actor) {
+	if (actor == 0) {
+		fputs("Kevin Bacon\n", out);
+	} else {
+		fprintf(out, "Actor %u\n", actor);
+	}
+}
+
+
+
+/*
+* main(argc, argv) -- writes a synthetic movies file to stdout.
+* argc: integer representing the number of command-line arguments.
+* argv: array of strings: the number of appearances (actor lines) to write and,
+*       optionally, a seed.
+* Returns: 0 on success, 1 on invalid arguments.
+* Assumptions: none.
+* Side effects: writes the file to stdout; allocates one stamp per actor.
+*/
+int main(int argc, char* argv[]) {
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s appearances [seed]\n", argv[0]);
+		return 1;
+	}
+
+	char *end;
+	unsigned long long appearances = strtoull(argv[1], &end, 10);
+
+	if (*end != '\0' || appearances < 1 || appearances > UINT32_MAX) {
+		fprintf(stderr, "Invalid Appearance Count.\n");
+		return 1;
+	}
+
+	uint64_t state = argc == 3 ? strtoull(argv[2], NULL, 10) : 1;
+	uint32_t numActors = appearances / APPEARANCES_PER_ACTOR + 2;
+
+	// Stamp of the last movie each actor was cast in, to keep casts free of repeats
+	uint32_t *lastMovie = malloc((size_t) numActors * sizeof(uint32_t));
+
+	if (lastMovie == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	memset(lastMovie, 0xFF, (size_t) numActors * sizeof(uint32_t));
+
+	static char buffer[1 << 20];
+	setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+	uint64_t written = 0;
+
+	for (uint32_t movie = 0; written < appearances; movie++) {
+		uint32_t cast = castSize(&state);
+
+		if (cast > appearances - written) {
+			cast = appearances - written;
+		}
+
+		fprintf(stdout, "Movie: Film %u\n", movie);
+
+		for (uint32_t index = 0; index < cast; index++) {
+			uint32_t actor = 0;
+
+			for (int tries = 0; tries < MAX_RETRIES; tries++) {
+				actor = (uint32_t) (numActors * pow(nextUniform(&state), ACTOR_SKEW));
+				if (lastMovie[actor] != movie) {
+					break;
+				}
+			}
+			lastMovie[actor] = movie;
+			printActor(stdout, actor);
+		}
+		written += cast;
+		fputc('\n', stdout);
+	}
+
+	free(lastMovie);
+	return fflush(stdout) != 0;
+}
@@ -1,5 +1,5 @@
 /*
-* File: bacon.c
+* File: BaconScore.c
 * Author: Chance Krueger
 * 
 * Purpose: 
@@ -14,651 +14,1760 @@
 *   The program builds an undirected graph, marking connections through 
 *   shared movie appearances. If an actor has a valid path to Kevin Bacon, 
 *   it returns the number of connections required to reach him; otherwise, 
-*   it outputs "No Bacon!" to indicate the absence of a link.
+*   it outputs "No Bacon!" to indicate the absence of a link. With the
+*   -l option it also prints the chain of shared movies that links them.
 * 
 *   Inspired by the "Oracle of Bacon," which popularized the concept, 
 *   this program allows users to determine their degrees of separation 
 *   from Kevin Bacon based on custom movie-actor data.
+*
+*   The graph itself is built and searched by the library in bacon.c; this
+*   file holds the command-line front end: options, the center cache, batch
+*   and interactive queries, reports and the query server.
 */
 
 
 
 
+// accept4 for the --serve event loop
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
 
-
-
-void printActorsWithMovies();
+#include "bacon_internal.h"
 
 
 
 /*
- * actorNode -- Represents an actor in the graph of actors and movies.
+ * centerTable -- Full-BFS results for one center actor, kept in the center cache.
  *
  * Fields:
- *   actorName - Pointer to a dynamically allocated string containing the actor's name.
- *   movies    - Pointer to a linked list (of type movieList) representing the movies
- *               in which the actor has appeared.
- *   next      - Pointer to the next actorNode in the overall linked list of actors.
- *   visited   - A flag used during graph traversal (e.g., BFS) to indicate whether
- *               this actor has been visited.
- *   level     - An integer used during graph traversal that indicates the distance
- *               (or “level”) from a start node.
+ *   center       - ID of the center actor.
+ *   distances    - Per-actor distance from the center (-1 = no path).
+ *   parents      - Per-actor next actor toward the center.
+ *   parentMovies - Per-actor movie shared with that next actor.
+ *   mapped       - Nonzero if the arrays are views of the snapshot, not allocations.
+ *   newer, older - Neighbours in the cache's most-recently-used order.
  */
-struct actorNode {
-
-	char *actorName;
-	struct movieList *movies; // char *movieName;
-	struct actorNode *next;
-	int visited;
-	int level;
+struct centerTable {
+	uint32_t center;
+	int *distances;
+	uint32_t *parents;
+	uint32_t *parentMovies;
+	int mapped;
+	struct centerTable *newer;
+	struct centerTable *older;
 };
 
 
 
 /*
- * movieNode -- Represents a movie in the graph connecting actors.
+ * queryStats -- Counters for --stats, updated by every thread that answers queries.
+ *
+ * They are always kept: each query costs a few relaxed atomic adds and clock reads,
+ * and the searches count what they touch in their own searchState.
  *
  * Fields:
- *   movieName - Pointer to a dynamically allocated string containing the movie's name.
- *   actors    - Pointer to a linked list (of type actorsInMovie) representing the actors
- *               that appear in the movie.
- *   next      - Pointer to the next movieNode in the overall linked list of movies.
+ *   answered       - Queries answered.
+ *   notFound       - Queries naming an actor that is not in the graph.
+ *   lookups        - Actor names looked up by answerQuery.
+ *   lookupNanos    - Time spent in those lookups.
+ *   pairSearches   - Pair queries answered by a bidirectional BFS.
+ *   searchNanos    - Time spent in those searches.
+ *   maxSearchNanos - Longest of those searches.
+ *   actorsTouched  - Actors reached by those searches.
+ *   moviesTouched  - Movies expanded by those searches.
+ *   labelAnswers   - Pair queries answered from the label index.
+ *   componentSkips - Pair queries answered by the components alone.
+ *   centerSearches - Full BFSAll runs for center tables.
+ *   centerNanos    - Time spent in those runs.
  */
-struct movieNode {
-
-	char *movieName;
-	struct actorsInMovie *actors;
-	struct movieNode *next;
+struct queryStats {
+	_Atomic uint64_t answered;
+	_Atomic uint64_t notFound;
+	_Atomic uint64_t lookups;
+	_Atomic uint64_t lookupNanos;
+	_Atomic uint64_t pairSearches;
+	_Atomic uint64_t searchNanos;
+	_Atomic uint64_t maxSearchNanos;
+	_Atomic uint64_t actorsTouched;
+	_Atomic uint64_t moviesTouched;
+	_Atomic uint64_t labelAnswers;
+	_Atomic uint64_t componentSkips;
+	_Atomic uint64_t centerSearches;
+	_Atomic uint64_t centerNanos;
 };
 
 
+// The movies file or snapshot being queried
+struct bacon_graph *graph = NULL;
+
+// Number of worker threads for parsing and batch queries (0 = one per online CPU)
+long workerThreads = 0;
+
+// Search state for single-source searches and the forward half of pair searches,
+// and for the backward half of pair searches
+struct searchState forwardSearch;
+struct searchState backwardSearch;
+
+// Current center (Kevin Bacon unless --center or @center picked another one), the
+// distance of every actor from it (-1 = no path) and the BFS tree it came from:
+// each actor's next actor and movie toward the center. These point into the
+// center cache's newest table.
+uint32_t baconActor = NO_ACTOR;
+int *baconDistances = NULL;
+uint32_t *baconParents = NULL;
+uint32_t *baconParentMovies = NULL;
+
+// Recently used center tables, newest first, kept within centerCacheBudget bytes
+// (always at least the current one)
+#define DEFAULT_CENTER_CACHE_MB 256
+size_t centerCacheBudget = (size_t) DEFAULT_CENTER_CACHE_MB << 20;
+struct centerTable *centerCacheNewest = NULL;
+struct centerTable *centerCacheOldest = NULL;
+size_t centerCacheCount = 0;
+
+// Number of similar names offered for an actor that is not found (0 = none)
+#define MAX_SUGGESTIONS 100
+int suggestCount = 0;
+
+// Counters printed by --stats
+struct queryStats queryStats;
+
+// Latency histograms: values below 2^LATENCY_SUB_BITS nanoseconds get a bucket each;
+// every higher power of two is split into 2^LATENCY_SUB_BITS equal buckets, so a
+// bucket is never wider than 1/32 of the values in it
+#define LATENCY_SUB_BITS 5
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+enum queryType { QUERY_SCORE, QUERY_PATH, QUERY_PAIR, QUERY_TYPES };
+
+const char *queryTypeNames[QUERY_TYPES] = { "score", "path", "pair" };
+
+// Answered queries of each type per latency bucket, from findActor to the answer
+_Atomic uint64_t latencyCounts[QUERY_TYPES][LATENCY_BUCKETS];
+
+
+
 
 /*
- * movieList -- Represents a node in an actor's list of movies.
- *
- * Fields:
- *   movie - Pointer to a movieNode that represents a movie in which the actor has appeared.
- *   next  - Pointer to the next node in the linked list of movies for the actor.
- */
-struct movieList {
-	struct movieNode *movie;
-   	struct movieList *next;
-};
+* addStat(counter, amount) -- adds to a --stats counter.
+* counter: pointer to a field of queryStats.
+* amount: value to add.
+* Returns: void.
+* Assumptions: none.
+* Side effects: updates *counter atomically, without ordering other memory.
+*/
+void addStat(_Atomic uint64_t *counter, uint64_t amount) {
+	atomic_fetch_add_explicit(counter, amount, memory_order_relaxed);
+}
 
 
 
 /*
- * actorsInMovie -- Represents a node in a movie's list of actors.
- *
- * Fields:
- *   to   - Pointer to an actorNode representing an actor who appears in the movie.
- *   next - Pointer to the next node in the linked list of actors for the movie.
- */
-struct actorsInMovie {
-	struct actorNode *to;
-	struct actorsInMovie *next;
-};
+* elapsedNanos(start) -- measures the time since an earlier clockSeconds reading.
+* start: the earlier reading.
+* Returns: the elapsed time in nanoseconds.
+* Assumptions: none.
+* Side effects: reads the clock.
+*/
+uint64_t elapsedNanos(double start) {
+
+	double elapsed = clockSeconds() - start;
+
+	return elapsed > 0 ? (uint64_t) (elapsed * 1e9) : 0;
+}
+
 
 
 /*
-* queue -- node for a simple linked-list queue used in BFS.
-* pNode: pointer to the phoneNode stored in this queue entry.
-* next: pointer to the next entry in the queue.
+* recordSearch(forward, backward, actorsBefore, moviesBefore, nanos) -- counts one
+*                             bidirectional pair search for --stats.
+* forward: pointer to the searchState the search was rooted at its start on.
+* backward: pointer to the searchState the search was rooted at its target on.
+* actorsBefore: actors the two states had touched before the search.
+* moviesBefore: movies the two states had touched before the search.
+* nanos: time the search took.
+* Returns: void.
+* Assumptions: the search was the only one on these states since the counts were read.
+* Side effects: updates queryStats.
 */
-struct queue {
-        struct actorNode *actor;
-        struct queue *next;
-};
+void recordSearch(const struct searchState *forward, const struct searchState *backward,
+		uint64_t actorsBefore, uint64_t moviesBefore, uint64_t nanos) {
+
+	addStat(&queryStats.pairSearches, 1);
+	addStat(&queryStats.searchNanos, nanos);
+	addStat(&queryStats.actorsTouched, forward->actorsTouched + backward->actorsTouched - actorsBefore);
+	addStat(&queryStats.moviesTouched, forward->moviesTouched + backward->moviesTouched - moviesBefore);
+
+	uint64_t longest = atomic_load_explicit(&queryStats.maxSearchNanos, memory_order_relaxed);
+	while (nanos > longest && !atomic_compare_exchange_weak_explicit(&queryStats.maxSearchNanos,
+			&longest, nanos, memory_order_relaxed, memory_order_relaxed)) {
+	}
+}
 
 
 
 /*
-* dequeue(head) -- removes and returns the front phoneNode from the queue.
-* head: pointer to the queue head pointer.
-* Returns: the dequeued phoneNode*, or NULL if the queue was empty.
-* Assumptions: *head is a valid pointer; queue entries have been allocated.
-* Side effects: frees the removed queue node.
+* latencyBucket(nanos) -- finds the histogram bucket of a latency.
+* nanos: the latency in nanoseconds.
+* Returns: the bucket index, below LATENCY_BUCKETS.
+* Assumptions: none.
+* Side effects: none.
 */
-struct actorNode* dequeue(struct queue **head) {
-    if (*head == NULL) {
-        return NULL;  // Return NULL if the queue is empty.
-    }
-    struct actorNode *node = (*head)->actor;
-    struct queue *temp = *head;
-    *head = (*head)->next;  // Move the head pointer to the next element
-    free(temp);
-    return node;
+size_t latencyBucket(uint64_t nanos) {
+
+	if (nanos < LATENCY_SUB_BUCKETS) {
+		return nanos;
+	}
+
+	int shift = 63 - __builtin_clzll(nanos) - LATENCY_SUB_BITS;
+
+	return (size_t) (shift + 1) * LATENCY_SUB_BUCKETS + (nanos >> shift) - LATENCY_SUB_BUCKETS;
 }
 
 
 
 /*
-* enqueue(head, pNode) -- creates a new queue entry holding pNode and appends it.
-* head: pointer to the queue head pointer.
-* pNode: pointer to the phoneNode to enqueue.
-* Returns: void.
-* Assumptions: head points to a valid queue pointer; memory allocation succeeds.
-* Side effects: allocates a new queue node and links it at the tail.
+* bucketLimit(bucket) -- gives the largest latency a histogram bucket holds.
+* bucket: the bucket index.
+* Returns: the latency in nanoseconds.
+* Assumptions: bucket < LATENCY_BUCKETS.
+* Side effects: none.
 */
-void enqueue(struct queue **head, struct actorNode *actor) {
-    struct queue *node = malloc(sizeof(struct queue));
-    node->actor = actor;
-    node->next = NULL;
+uint64_t bucketLimit(size_t bucket) {
+
+	if (bucket < LATENCY_SUB_BUCKETS) {
+		return bucket;
+	}
 
-    if (*head == NULL) {
-        *head = node;  // If the queue is empty, the new node is the head.
-        return;
-    }
+	int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+	uint64_t first = (uint64_t) (bucket % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS) << shift;
 
-    struct queue *cur = *head;
-    while (cur->next != NULL) {
-        cur = cur->next;
-    }
-    cur->next = node;  // Add the new node to the end of the queue
+	return first + ((1ULL << shift) - 1);
 }
 
 
-// Main linked lists
-struct actorNode *headActors = NULL;
-struct movieNode *headMovies = NULL;
+
+/*
+* recordLatency(type, start) -- adds an answered query to its latency histogram.
+* type: the kind of query.
+* start: clockSeconds reading taken before its first name lookup.
+* Returns: void.
+* Assumptions: called once the whole answer, connection path included, is written.
+* Side effects: increments one bucket of latencyCounts atomically.
+*/
+void recordLatency(enum queryType type, double start) {
+	addStat(&latencyCounts[type][latencyBucket(elapsedNanos(start))], 1);
+}
 
 
 
 /*
-* findMovie(line) -- extracts the movie title from a formatted input string.
-* line: pointer to a string containing the full movie entry (e.g., "Movie: Title").
-* Returns: a newly allocated string containing the movie title, with the prefix removed.
-* Assumptions: line contains a ':' separating "Movie" from the title.
-* Side effects: dynamically allocates memory for the returned string; caller must free it.
+* printLatencies(out) -- writes p50, p99, p999 and the maximum of every latency histogram.
+* out: pointer to the output stream.
+* Returns: void.
+* Assumptions: none; queries may still be recorded meanwhile, which only makes the
+*              figures a little inexact.
+* Side effects: writes one line per query type that has been seen to out.
 */
-char* findMovie(char *line) {
+void printLatencies(FILE *out) {
+
+	static const double fractions[] = { 0.5, 0.99, 0.999, 1.0 };
+
+	for (int type = 0; type < QUERY_TYPES; type++) {
+		uint64_t counts[LATENCY_BUCKETS];
+		uint64_t total = 0;
+
+		for (size_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+			counts[bucket] = atomic_load_explicit(&latencyCounts[type][bucket], memory_order_relaxed);
+			total += counts[bucket];
+		}
+		if (total == 0) {
+			continue;
+		}
 
-	char *movie = strdup(line);
-	char *og = movie;
+		// Each percentile is the limit of the bucket that holds its rank
+		double values[4];
+		uint64_t seen = 0;
+		size_t bucket = 0;
 
-	while (*movie != ':') {
-		movie++;
+		for (int index = 0; index < 4; index++) {
+			uint64_t rank = (uint64_t) (fractions[index] * total + 0.999999);
+
+			if (rank < 1) {
+				rank = 1;
+			}
+			while (seen + counts[bucket] < rank) {
+				seen += counts[bucket++];
+			}
+			values[index] = bucketLimit(bucket) / 1e3;
+		}
+		fprintf(out, "Latency %s: count %llu, p50 %.1f us, p99 %.1f us, p999 %.1f us, max %.1f us\n",
+			queryTypeNames[type], (unsigned long long) total, values[0], values[1], values[2], values[3]);
 	}
-	// GET RID OF SPACE BEFORE ':'
-	movie += 2;
-	char* duped = strdup(movie);
-	free(og);
-	return duped;
+	fflush(out);
 }
 
 
+
 /*
-* containsMovie(line) -- determines whether a given string contains a movie entry.
-* line: pointer to a string that may represent a movie or actor entry.
-* Returns: 1 if the string contains a movie identifier (":"), otherwise 0.
-* Assumptions: line is a valid, null-terminated string.
-* Side effects: none.
+* latencySignalThread(arg) -- prints the latency histograms whenever SIGUSR1 arrives.
+* arg: unused.
+* Returns: never.
+* Assumptions: SIGUSR1 is blocked in every thread, so only sigwait here receives it.
+* Side effects: writes to stderr on each signal.
 */
-int containsMovie(char *line) {
+void* latencySignalThread(void *arg) {
 
-	for (int index = 0; line[index] != 0; index++) {
-		if (line[index] == ':') {
-			return 1;
+	(void) arg;
+	sigset_t signals;
+
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+
+	for (;;) {
+		int received;
+
+		if (sigwait(&signals, &received) == 0) {
+			printLatencies(stderr);
 		}
 	}
-	return 0;
+	return NULL;
 }
 
 
 
+/*
+* printStats(out) -- writes the load and query counters as one JSON object.
+* out: pointer to the output stream.
+* Returns: void.
+* Assumptions: the graph is loaded and no thread is answering queries.
+* Side effects: writes to out.
+*/
+void printStats(FILE *out) {
+
+	const struct loadStats *load = &graph->stats;
+	uint64_t searches = queryStats.pairSearches;
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"load\": {\"bytes_read\": %llu, \"lines\": %llu, \"load_seconds\": %.6f, "
+		"\"parse_seconds\": %.6f, \"build_seconds\": %.6f},\n",
+		(unsigned long long) load->bytesRead, (unsigned long long) load->lines,
+		load->loadSeconds, load->parseSeconds, load->buildSeconds);
+	fprintf(out, "  \"graph\": {\"actors\": %u, \"movies\": %u, \"edges\": %u},\n",
+		graph->csr.numActors, graph->csr.numMovies, graph->csr.numEdges);
+	fprintf(out, "  \"queries\": {\"answered\": %llu, \"not_found\": %llu, \"lookups\": %llu, "
+		"\"lookup_seconds\": %.6f},\n",
+		(unsigned long long) queryStats.answered, (unsigned long long) queryStats.notFound,
+		(unsigned long long) queryStats.lookups, queryStats.lookupNanos / 1e9);
+	fprintf(out, "  \"pair_searches\": {\"count\": %llu, \"seconds\": %.6f, \"mean_seconds\": %.9f, "
+		"\"max_seconds\": %.9f, \"actors_touched\": %llu, \"movies_touched\": %llu, "
+		"\"mean_actors_touched\": %.1f, \"mean_movies_touched\": %.1f},\n",
+		(unsigned long long) searches, queryStats.searchNanos / 1e9,
+		searches > 0 ? queryStats.searchNanos / 1e9 / searches : 0.0, queryStats.maxSearchNanos / 1e9,
+		(unsigned long long) queryStats.actorsTouched, (unsigned long long) queryStats.moviesTouched,
+		searches > 0 ? (double) queryStats.actorsTouched / searches : 0.0,
+		searches > 0 ? (double) queryStats.moviesTouched / searches : 0.0);
+	fprintf(out, "  \"pairs_without_search\": {\"label_index\": %llu, \"components\": %llu},\n",
+		(unsigned long long) queryStats.labelAnswers, (unsigned long long) queryStats.componentSkips);
+	fprintf(out, "  \"center_searches\": {\"count\": %llu, \"seconds\": %.6f}\n",
+		(unsigned long long) queryStats.centerSearches, queryStats.centerNanos / 1e9);
+	fprintf(out, "}\n");
+}
+
+
 
 /*
-* addMovieToActorsMovies(actor, movie) -- links a movie to an actor's list of appearances.
-* actor: pointer to the actorNode representing the actor.
-* movie: pointer to the movieNode representing the movie.
+* unlinkCenter(table) -- removes a table from the center cache's order.
+* table: pointer to a centerTable in the cache.
 * Returns: void.
-* Assumptions: actor and movie pointers are valid and properly allocated.
-* Side effects: dynamically allocates memory for a new movieList node and appends it
-*               to the actor's movie list.
+* Assumptions: table is linked into the cache.
+* Side effects: relinks its neighbours and decrements centerCacheCount.
 */
-void addMovieToActorsMovies(struct actorNode *actor, struct movieNode *movie) {
-	
-	struct movieList *curMovie = actor->movies;
+void unlinkCenter(struct centerTable *table) {
 
-	struct movieList *addMovie = malloc(sizeof(struct movieList));
-	
-	if (addMovie == NULL) {
-		fprintf(stderr, "Not enough Mem.\n");
+	if (table->newer != NULL) {
+		table->newer->older = table->older;
+	} else {
+		centerCacheNewest = table->older;
+	}
+	if (table->older != NULL) {
+		table->older->newer = table->newer;
+	} else {
+		centerCacheOldest = table->newer;
+	}
+	table->newer = table->older = NULL;
+	centerCacheCount--;
+}
+
+
+
+/*
+* freeCenter(table) -- frees a center table.
+* table: pointer to a centerTable no longer in the cache.
+* Returns: void.
+* Assumptions: none.
+* Side effects: deallocates the table and, unless they are snapshot views, its arrays.
+*/
+void freeCenter(struct centerTable *table) {
+
+	if (!table->mapped) {
+		free(table->distances);
+		free(table->parents);
+		free(table->parentMovies);
+	}
+	free(table);
+}
+
+
+
+/*
+* cacheCenter(table) -- makes a table the newest in the center cache and the current center.
+* table: pointer to a centerTable not linked into the cache.
+* Returns: void.
+* Assumptions: the graph is ready.
+* Side effects: links table in front, evicts the least recently used tables while the
+*               cache is over centerCacheBudget, and points the baconActor globals at table.
+*/
+void cacheCenter(struct centerTable *table) {
+
+	table->newer = NULL;
+	table->older = centerCacheNewest;
+	if (centerCacheNewest != NULL) {
+		centerCacheNewest->newer = table;
+	} else {
+		centerCacheOldest = table;
+	}
+	centerCacheNewest = table;
+	centerCacheCount++;
+
+	size_t tableBytes = ((size_t) graph->csr.numActors + 1) * (sizeof(int) + 2 * sizeof(uint32_t));
+	size_t capacity = centerCacheBudget / tableBytes;
+
+	while (centerCacheCount > 1 && centerCacheCount > capacity) {
+		struct centerTable *oldest = centerCacheOldest;
+		unlinkCenter(oldest);
+		freeCenter(oldest);
+	}
+
+	baconActor = table->center;
+	baconDistances = table->distances;
+	baconParents = table->parents;
+	baconParentMovies = table->parentMovies;
+}
+
+
+
+/*
+* addMappedCenter() -- enters the Bacon table of a loaded snapshot into the center cache.
+* Returns: void.
+* Assumptions: the snapshot holds a table, so graph->snapshotCenter is not NO_ACTOR.
+* Side effects: allocates a cache entry that borrows the mapped arrays and makes it
+*               the current center.
+*/
+void addMappedCenter() {
+
+	struct centerTable *table = malloc(sizeof(struct centerTable));
+
+	if (table == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
 		exit(1);
 	}
+	table->center = graph->snapshotCenter;
+	table->distances = graph->snapshotDistances;
+	table->parents = graph->snapshotParents;
+	table->parentMovies = graph->snapshotParentMovies;
+	table->mapped = 1;
+	cacheCenter(table);
+}
 
-	addMovie->movie = movie;
-	addMovie->next = NULL;
-	
-	if (curMovie == NULL) {
-		actor->movies = addMovie;
+
+
+/*
+* useCenter(center) -- makes an actor the center that scores are measured from.
+* center: ID of the new center, or NO_ACTOR when there is none (every score is
+*         then "No Bacon!").
+* Returns: void.
+* Assumptions: the graph is ready and no other thread is answering queries.
+* Side effects: reuses the center's cached table when there is one; otherwise
+*               allocates a table, fills it with one full BFSAll (counted in
+*               queryStats) and caches it. Points the baconActor globals at the table.
+*/
+void useCenter(uint32_t center) {
+
+	if (center == NO_ACTOR) {
+		baconActor = NO_ACTOR;
+		baconDistances = NULL;
+		baconParents = NULL;
+		baconParentMovies = NULL;
 		return;
 	}
 
-	while (curMovie->next != NULL) {
-		curMovie = curMovie->next;
+	for (struct centerTable *table = centerCacheNewest; table != NULL; table = table->older) {
+		if (table->center == center) {
+			unlinkCenter(table);
+			cacheCenter(table);
+			return;
+		}
 	}
 
-	curMovie->next = addMovie;
+	struct centerTable *table = malloc(sizeof(struct centerTable));
+
+	if (table == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	table->center = center;
+	table->distances = malloc(((size_t) graph->csr.numActors + 1) * sizeof(int));
+	table->parents = malloc(((size_t) graph->csr.numActors + 1) * sizeof(uint32_t));
+	table->parentMovies = malloc(((size_t) graph->csr.numActors + 1) * sizeof(uint32_t));
+	table->mapped = 0;
+
+	if (table->distances == NULL || table->parents == NULL || table->parentMovies == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	double start = clockSeconds();
+	BFSAll(&forwardSearch, center, table->distances, table->parents, table->parentMovies);
+	addStat(&queryStats.centerSearches, 1);
+	addStat(&queryStats.centerNanos, elapsedNanos(start));
+	cacheCenter(table);
 }
 
 
 
 /*
-* addMovieToLL(node) -- adds a movieNode to the global linked list of movies.
-* node: pointer to the movieNode to be inserted.
+* freeCenterCache() -- frees every table in the center cache.
 * Returns: void.
-* Assumptions: node is a valid, dynamically allocated movieNode.
-* Side effects: updates headMovies if the list is empty, appends node at the tail.
+* Assumptions: none.
+* Side effects: empties the cache and clears the baconActor globals.
 */
-void addMovieToLL(struct movieNode *node) {
+void freeCenterCache() {
 
-	if (headMovies == NULL) {
-                headMovies = node;
-                node->next = NULL;
-                return;
-        }
+	while (centerCacheNewest != NULL) {
+		struct centerTable *table = centerCacheNewest;
+		unlinkCenter(table);
+		freeCenter(table);
+	}
+	useCenter(NO_ACTOR);
+}
 
-        struct movieNode *cur = headMovies;
 
-        while (cur->next != NULL) {
-                cur = cur->next;
-        }
-        cur->next = node;
-        node->next = NULL;
 
+/*
+* centerCommand(line) -- recognizes a "@center Name" line that switches the center.
+* line: pointer to a query line without its newline.
+* Returns: pointer to the name within line, or NULL if line is an ordinary query.
+* Assumptions: none.
+* Side effects: none.
+*/
+char* centerCommand(char *line) {
 
+	if (strncmp(line, "@center ", strlen("@center ")) != 0) {
+		return NULL;
+	}
+	return line + strlen("@center ");
 }
 
 
 
+
 /*
-* addActorNode(node) -- adds an actorNode to the global linked list of actors.
-* node: pointer to the actorNode to be inserted.
+* trimName(name) -- strips leading and trailing spaces and tabs from a name in place.
+* name: pointer to a modifiable, null-terminated string.
+* Returns: pointer to the first non-blank character of name.
+* Assumptions: name is a valid, null-terminated string.
+* Side effects: may write a null terminator over trailing blanks.
+*/
+char* trimName(char *name) {
+
+	while (*name == ' ' || *name == '\t') {
+		name++;
+	}
+
+	size_t len = strlen(name);
+	while (len > 0 && (name[len - 1] == ' ' || name[len - 1] == '\t')) {
+		name[--len] = '\0';
+	}
+	return name;
+}
+
+
+
+
+/*
+* printSuggestions(state, name, out) -- offers the actor names closest to one that was not found.
+* state: pointer to the calling thread's searchState, used as scratch space.
+* name: pointer to the null-terminated name.
+* out: pointer to the stream that receives the suggestions.
 * Returns: void.
-* Assumptions: node is a valid, dynamically allocated actorNode.
-* Side effects: updates headActors if the list is empty, appends node at the tail.
+* Assumptions: the trigram index is built when suggestCount is not 0.
+* Side effects: writes "Did you mean: A, B, C?" to out when there is any suggestion.
 */
-void addActorNode(struct actorNode *node) {
-	if (headActors == NULL) {
-		headActors = node;
-		node->next = NULL;
+void printSuggestions(struct searchState *state, const char *name, FILE *out) {
+
+	if (suggestCount == 0) {
 		return;
 	}
 
-	struct actorNode *cur = headActors;
+	uint32_t *ids = malloc(suggestCount * sizeof(uint32_t));
 
-	while (cur->next != NULL) {
-		cur = cur->next;
+	if (ids == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	int found = suggestActors(state, name, strlen(name), ids, suggestCount);
+
+	for (int index = 0; index < found; index++) {
+		fprintf(out, index == 0 ? "Did you mean: " : ", ");
+		printName(graph, out, graph->actorNames[ids[index]]);
 	}
-	cur->next = node;
-	node->next = NULL;
+	if (found > 0) {
+		fprintf(out, "?\n");
+	}
+	free(ids);
 }
 
 
 
 /*
-* addActorToMovie(movie, actor) -- adds an actor to a movie's linked list of actors.
-* movie: pointer to the movieNode representing the movie.
-* actor: pointer to the actorNode representing the actor.
-* Returns: void.
-* Assumptions: movie and actor pointers are valid and properly allocated.
-* Side effects: dynamically allocates a new actorsInMovie node and appends it to
-*               the movie's list of actors, ensuring no duplicate actors are added.
+* answerQuery(query, forward, backward, printPaths, out, errOut) -- answers one line of input.
+* query: pointer to a modifiable query line without its newline: an actor name for a
+*        Bacon score, or "Actor A | Actor B" for the distance between two actors.
+* forward: pointer to the searchState used for pair searches rooted at Actor A.
+* backward: pointer to the searchState used for pair searches rooted at Actor B.
+* printPaths: nonzero to follow each score with its connection path (-l).
+* out: pointer to the stream that receives the answer.
+* errOut: pointer to the stream that receives the not-found message and the suggestions
+*         that go with it.
+* Returns: 0 if the query was answered, -1 if an actor could not be found.
+* Assumptions: the graph and the Bacon table are ready; the two states belong to the
+*              calling thread.
+* Side effects: may modify query and run a bidirectional BFS on the two states;
+*               writes the answer to out, or "Actor Could Not be Found." followed by
+*               suggestions for each missing name to errOut, and counts the query in queryStats and, once answered, in the
+*               latency histogram of its type.
 */
-void addActorToMovie(struct movieNode *movie, struct actorNode *actor) {
+int answerQuery(char *query, struct searchState *forward, struct searchState *backward, int printPaths,
+		FILE *out, FILE *errOut) {
+
+	// "Actor A | Actor B" asks for the distance between two arbitrary actors
+	char *separator = strchr(query, '|');
+
+	if (separator != NULL) {
+		*separator = '\0';
+		char *fromName = trimName(query);
+		char *toName = trimName(separator + 1);
+		double queryStart = clockSeconds();
+		uint32_t from = lookupActor(graph, fromName, strlen(fromName));
+		uint32_t to = lookupActor(graph, toName, strlen(toName));
+
+		addStat(&queryStats.lookups, 2);
+		addStat(&queryStats.lookupNanos, elapsedNanos(queryStart));
+
+		if (from == NO_ACTOR || to == NO_ACTOR) {
+			addStat(&queryStats.notFound, 1);
+			fprintf(errOut, "Actor Could Not be Found.\n");
+			if (from == NO_ACTOR) {
+				printSuggestions(forward, fromName, errOut);
+			}
+			if (to == NO_ACTOR) {
+				printSuggestions(forward, toName, errOut);
+			}
+			return -1;
+		}
 
-	struct actorsInMovie *curActor = movie->actors;
+		// Different components: no search could connect them. Without -l, the
+		// label index (when loaded) gives the distance without searching at all
+		uint32_t meet;
+		int distance;
+
+		if (graph->components[from] != graph->components[to]) {
+			distance = -1;
+			addStat(&queryStats.componentSkips, 1);
+		} else if (graph->labelOffsets != NULL && !printPaths) {
+			distance = labelDistance(graph, from, to);
+			addStat(&queryStats.labelAnswers, 1);
+		} else {
+			uint64_t actorsBefore = forward->actorsTouched + backward->actorsTouched;
+			uint64_t moviesBefore = forward->moviesTouched + backward->moviesTouched;
 
-	struct actorsInMovie *newActor = malloc(sizeof(struct actorsInMovie));
+			double start = clockSeconds();
+			distance = BFS(forward, backward, from, to, &meet);
+			recordSearch(forward, backward, actorsBefore, moviesBefore, elapsedNanos(start));
+		}
 
-	if (newActor == NULL) {
-		fprintf(stderr, "Not Enough Space.\n");
-		exit(1);
+		if (distance == -1) {
+			fprintf(out, "Score: No Connection!\n");
+		} else {
+			fprintf(out, "Score: %d\n", distance);
+			if (printPaths) {
+				printPairPath(out, forward, backward, to, meet);
+			}
+		}
+		recordLatency(printPaths ? QUERY_PATH : QUERY_PAIR, queryStart);
+		addStat(&queryStats.answered, 1);
+		return 0;
 	}
 
-	newActor->to = actor;
-	newActor->next = NULL;
+	double queryStart = clockSeconds();
+	uint32_t actor = lookupActor(graph, query, strlen(query));
 
-	if (curActor == NULL) {
-		movie->actors = newActor;
-		return;
+	addStat(&queryStats.lookups, 1);
+	addStat(&queryStats.lookupNanos, elapsedNanos(queryStart));
+
+	if (actor == NO_ACTOR) {
+		addStat(&queryStats.notFound, 1);
+		fprintf(errOut, "Actor Could Not be Found.\n");
+		printSuggestions(forward, query, errOut);
+		return -1;
 	}
 
-	while (curActor->next != NULL) {
-		// COPY, DONT ADD, SHOULD NEVER BE TRUE
-		if (strcmp(curActor->to->actorName, actor->actorName) == 0) {
-			return;
+	// No Bacon in Graph, Dont have to check it.
+	if (baconActor == NO_ACTOR || baconDistances[actor] == -1) {
+		fprintf(out, "Score: No Bacon!\n");
+	} else {
+		fprintf(out, "Score: %d\n", baconDistances[actor]);
+
+		// -l: the path is read straight off the precomputed Bacon tree
+		if (printPaths) {
+			printPath(graph, out, actor, baconActor, baconParents, baconParentMovies);
 		}
-		curActor = curActor->next;
 	}
-	curActor->next = newActor;
+	recordLatency(printPaths ? QUERY_PATH : QUERY_SCORE, queryStart);
+	addStat(&queryStats.answered, 1);
+	return 0;
 }
 
 
 
 /*
-* findActor(actor) -- searches for an actor in the global linked list of actors.
-* actor: pointer to a string containing the actor's name.
-* Returns: pointer to the actorNode if found, otherwise NULL.
-* Assumptions: headActors is a valid pointer to the linked list of actors.
-* Side effects: none.
+ * batchQuery -- One line of a batch, with its answer once computed.
+ *
+ * Fields:
+ *   text         - The query line, without its newline.
+ *   unique       - Index of the first query with the same text; only that one is answered.
+ *   answer       - Buffer holding everything the query prints to standard output.
+ *   answerLength - Length of answer in bytes.
+ *   errors       - Buffer holding everything the query prints to standard error.
+ *   errorsLength - Length of errors in bytes.
+ *   notFound     - Nonzero if an actor in the query could not be found.
+ */
+struct batchQuery {
+	char *text;
+	size_t unique;
+	char *answer;
+	size_t answerLength;
+	char *errors;
+	size_t errorsLength;
+	int notFound;
+};
+
+
+
+/*
+ * batchJob -- Work shared by the threads answering a batch.
+ *
+ * Fields:
+ *   queries    - All queries of the batch, in input order.
+ *   uniques    - Indexes of the distinct queries, the only ones answered.
+ *   numUniques - Number of entries in uniques.
+ *   next       - Next entry of uniques to claim.
+ *   printPaths - Nonzero to include connection paths (-l).
+ */
+struct batchJob {
+	struct batchQuery *queries;
+	size_t *uniques;
+	size_t numUniques;
+	atomic_size_t next;
+	int printPaths;
+};
+
+
+
+/*
+* batchWorker(arg) -- answers distinct batch queries until none are left.
+* arg: pointer to the shared batchJob.
+* Returns: NULL.
+* Assumptions: the graph and the Bacon table are ready and no longer change.
+* Side effects: sets up and frees this thread's own pair of search states; fills in
+*               the answer of every query it claims.
 */
-struct actorNode* findActor(char *actor) {
-	struct actorNode *cur = headActors;
+void* batchWorker(void *arg) {
 
-        while (cur != NULL) {
-                if (strcmp(cur->actorName, actor) == 0) {
-                        return cur;
-                }
-                cur = cur->next;
-        }
-        return NULL;
+	struct batchJob *job = arg;
+	struct searchState forward;
+	struct searchState backward;
+
+	initSearchState(graph, &forward);
+	initSearchState(graph, &backward);
+
+	size_t claimed;
+	while ((claimed = atomic_fetch_add(&job->next, 1)) < job->numUniques) {
+		struct batchQuery *query = &job->queries[job->uniques[claimed]];
+
+		// answerQuery may cut the text, and duplicates still need it for hashing
+		char *text = strdup(query->text);
+		FILE *out = open_memstream(&query->answer, &query->answerLength);
+		FILE *errOut = open_memstream(&query->errors, &query->errorsLength);
+
+		if (text == NULL || out == NULL || errOut == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+
+		query->notFound = answerQuery(text, &forward, &backward, job->printPaths, out, errOut) != 0;
+		fclose(out);
+		fclose(errOut);
+		free(text);
+	}
+
+	freeSearchState(&forward);
+	freeSearchState(&backward);
+	return NULL;
 }
 
 
 
 /*
-* isInLL(actor) -- checks whether an actor is present in the global linked list.
-* actor: pointer to a string containing the actor's name.
-* Returns: 1 if the actor exists in the linked list, otherwise 0.
-* Assumptions: headActors points to a valid linked list of actorNode structures.
-* Side effects: none.
+* answerBatch(queries, numQueries, printPaths) -- answers a run of batch queries on a
+*                             thread pool.
+* queries: array of numQueries queries, in input order.
+* numQueries: number of entries in queries.
+* printPaths: nonzero to include connection paths (-l).
+* Returns: 1 if any actor could not be found, otherwise 0.
+* Assumptions: the graph and the current center's table are ready.
+* Side effects: fills in the answers and prints them to standard output (and every
+*               not-found error to standard error) in input order.
+*
+* Repeated queries are answered once: a hash table over the query text maps each
+* line to its first occurrence, and only those are handed to the workers.
 */
-int isInLL(char *actor) {
-	struct actorNode *cur = headActors;
+int answerBatch(struct batchQuery *queries, size_t numQueries, int printPaths) {
 
-        while (cur != NULL) {
-	
-                if (strcmp(cur->actorName, actor) == 0) {
-			return 1;
+	// Deduplicate through an open-addressing table of query indexes
+	size_t capacity = 1024;
+	while (capacity < numQueries * 2) {
+		capacity *= 2;
+	}
+
+	size_t *slots = malloc(capacity * sizeof(size_t));
+	size_t *uniques = malloc((numQueries + 1) * sizeof(size_t));
+	size_t numUniques = 0;
+
+	if (slots == NULL || uniques == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	for (size_t index = 0; index < capacity; index++) {
+		slots[index] = SIZE_MAX;
+	}
+
+	for (size_t index = 0; index < numQueries; index++) {
+		const char *text = queries[index].text;
+		size_t slot = hashName(text, strlen(text)) & (capacity - 1);
+
+		while (slots[slot] != SIZE_MAX && strcmp(queries[slots[slot]].text, text) != 0) {
+			slot = (slot + 1) & (capacity - 1);
 		}
-		
-		cur = cur->next;
 
+		if (slots[slot] == SIZE_MAX) {
+			slots[slot] = index;
+			uniques[numUniques++] = index;
+		}
+		queries[index].unique = slots[slot];
 	}
-	return 0;
+	free(slots);
+
+	struct batchJob job;
+	job.queries = queries;
+	job.uniques = uniques;
+	job.numUniques = numUniques;
+	job.printPaths = printPaths;
+	atomic_init(&job.next, 0);
+
+	long threads = workerThreads > 0 ? workerThreads : sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (threads < 1) {
+		threads = 1;
+	}
+	if ((size_t) threads > numUniques) {
+		threads = numUniques > 0 ? numUniques : 1;
+	}
+
+	pthread_t *workers = calloc(threads, sizeof(pthread_t));
+	int *started = calloc(threads, sizeof(int));
+
+	if (workers == NULL || started == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	// This thread works too; any worker that fails to start is simply not needed
+	for (long index = 1; index < threads; index++) {
+		started[index] = pthread_create(&workers[index], NULL, batchWorker, &job) == 0;
+	}
+	batchWorker(&job);
+	for (long index = 1; index < threads; index++) {
+		if (started[index]) {
+			pthread_join(workers[index], NULL);
+		}
+	}
+	free(workers);
+	free(started);
+
+	int errSeen = 0;
+
+	for (size_t index = 0; index < numQueries; index++) {
+		struct batchQuery *answered = &queries[queries[index].unique];
+
+		// Answers go to stdout and not-found messages (with their suggestions) to stderr
+		fwrite(answered->answer, 1, answered->answerLength, stdout);
+		if (answered->notFound) {
+			errSeen = 1;
+			fflush(stdout);
+			fwrite(answered->errors, 1, answered->errorsLength, stderr);
+		}
+	}
+
+	free(uniques);
+	return errSeen;
 }
 
-	
+
 
 /*
-* parseFile(file) -- reads and processes a file containing movie and actor information.
-* file: pointer to an open FILE stream containing movie-actor data.
-* Returns: void.
-* Assumptions: file is a valid pointer to an open file.
-* Side effects: dynamically allocates memory for movie and actor nodes, modifies global
-*               linked lists (headMovies and headActors), and frees allocated strings.
+* runBatch(in, printPaths) -- answers every query line of a stream on a thread pool.
+* in: pointer to the stream of query lines.
+* printPaths: nonzero to include connection paths (-l).
+* Returns: 1 if any actor or center could not be found, otherwise 0.
+* Assumptions: the graph and the current center's table are ready.
+* Side effects: reads in to the end, prints every answer to standard output (and
+*               every not-found error to standard error) in input order, and frees
+*               everything it allocated. "@center Name" lines switch the center for
+*               the lines after them, so the queries between two of them are
+*               answered together.
 */
-void parseFile(FILE *file) {
-
-	char *movieTitle = NULL;
+int runBatch(FILE *in, int printPaths) {
 
-	struct movieNode *movie = NULL;
-	
+	struct batchQuery *queries = NULL;
+	size_t numQueries = 0;
+	size_t queriesCapacity = 0;
 
 	char *line = NULL;
-	size_t size = 0;
+	size_t len = 0;
+	ssize_t got;
 
-	while ((getline(&line, &size, file)) > 0) {
-		
-		// NEW LINE, GO TO NEXT ITERATION/LINE
-		if (isspace(line[0])) {
-			continue;
+	while ((got = getline(&line, &len, in)) > 0) {
+
+		if (line[got - 1] == '\n') {
+			line[got - 1] = '\0';
 		}
 
-		// Get rid of newline char
-		if (line[strlen(line) - 1] == '\n') {
-    			line[strlen(line) - 1] = '\0';
+		if (numQueries == queriesCapacity) {
+			queriesCapacity = queriesCapacity == 0 ? 1024 : queriesCapacity * 2;
+			queries = realloc(queries, queriesCapacity * sizeof(struct batchQuery));
+
+			if (queries == NULL) {
+				fprintf(stderr, "Not Enough Memory.\n");
+				exit(1);
+			}
 		}
 
-		// If it contains a ':'
-		if (containsMovie(line)) {
-			
-			// ADD MOVIE TO MOVIELL AND ADD MOVIE TO EVERY ACTORS MOVIE LIST
-                        if (movie != NULL) {
-				addMovieToLL(movie);
-                                free(movieTitle);
-                        	movieTitle = NULL;
-                        }
+		struct batchQuery *query = &queries[numQueries++];
+		query->text = strdup(line);
+		query->answer = NULL;
+		query->answerLength = 0;
+		query->errors = NULL;
+		query->errorsLength = 0;
+		query->notFound = 0;
+
+		if (query->text == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+	}
+	free(line);
 
-			movieTitle = (findMovie(line));
+	int errSeen = 0;
+	size_t first = 0;
 
-			movie = malloc(sizeof(struct movieNode));
-			
-			if (movie == NULL) {
-                                fprintf(stderr, "Not Enough Memory.\n");
-                        	exit(1);
-                        }
-			
-			movie->movieName = strdup(movieTitle);
-			movie->next = NULL;
-			movie->actors = NULL;
+	for (size_t index = 0; index <= numQueries; index++) {
+		char *centerName = index < numQueries ? centerCommand(queries[index].text) : NULL;
 
-		} else {
-			// ADD NODE
-			
-			// NODE ALREADY EXISTS
-			if (isInLL(line)) {
-				struct actorNode *actor = findActor(line);
-				addMovieToActorsMovies(actor, movie);
-				addActorToMovie(movie, actor);
+		if (index < numQueries && centerName == NULL) {
+			continue;
+		}
+
+		errSeen |= answerBatch(&queries[first], index - first, printPaths);
+		first = index + 1;
+
+		if (centerName != NULL) {
+			centerName = trimName(centerName);
+			uint32_t center = lookupActor(graph, centerName, strlen(centerName));
+
+			if (center == NO_ACTOR) {
+				errSeen = 1;
+				fflush(stdout);
+				fprintf(stderr, "Actor Could Not be Found.\n");
 			} else {
-				// CREATE NODE
-				struct actorNode *actor = malloc(sizeof(struct actorNode));
-				
-				if (actor == NULL) {
-					fprintf(stderr, "Not Enough Memory.\n");
-					exit(1);
-				}
-				
-				actor->actorName = strdup(line);
-				actor->movies = NULL;
-				actor->next = NULL;
-				actor->movies = NULL;
-				actor->visited = 0;
-				actor->level = 0;
-				addActorNode(actor);
-				addMovieToActorsMovies(actor, movie);
-				addActorToMovie(movie, actor);
-			}
-		}
-	}
-	if (movieTitle != NULL) {
-		addMovieToLL(movie);
-                free(movieTitle);
-                movieTitle = NULL;
-        }
-	free(line);
+				useCenter(center);
+			}
+		}
+	}
+
+	for (size_t index = 0; index < numQueries; index++) {
+		free(queries[index].text);
+		free(queries[index].answer);
+		free(queries[index].errors);
+	}
+	free(queries);
+	return errSeen;
 }
 
 
 
+
+// Longest request line a --serve client may send
+#define SERVE_MAX_LINE (64 * 1024)
+
+// How long --serve stops accepting after running out of descriptors, in milliseconds
+#define SERVE_ACCEPT_RETRY_MS 100
+
 /*
-* freeActorsInMovie(head) -- frees the linked list of actorsInMovie nodes.
-* head: pointer to the first node in the actorsInMovie linked list.
+ * serveClient -- One connection to the query server.
+ *
+ * Fields:
+ *   fd            - The connected socket.
+ *   in            - Received bytes not yet consumed as request lines.
+ *   inLength      - Number of bytes in in.
+ *   inCapacity    - Allocated size of in.
+ *   out           - Response bytes not yet sent.
+ *   outLength     - Number of bytes in out.
+ *   outSent       - Bytes of out already sent.
+ *   request       - Line being answered by a worker, or NULL when the client is idle.
+ *   response      - Answer to request, set by the worker.
+ *   responseLength - Length of response.
+ *   inputDone     - Nonzero once the peer has shut down its sending side; the
+ *                   lines already received are still answered.
+ *   closed        - Nonzero once the connection failed or has nothing left to answer;
+ *                   the client is freed when idle.
+ *   next          - Link in the server's pending or finished list.
+ */
+struct serveClient {
+	int fd;
+	char *in;
+	size_t inLength;
+	size_t inCapacity;
+	char *out;
+	size_t outLength;
+	size_t outSent;
+	char *request;
+	char *response;
+	size_t responseLength;
+	int inputDone;
+	int closed;
+	struct serveClient *next;
+};
+
+/*
+ * server -- State shared by the event loop and the worker pool of --serve.
+ *
+ * Fields:
+ *   lock           - Guards the two lists and stopping.
+ *   wake           - Signalled when a request is queued or the server stops.
+ *   pendingHead    - Oldest client whose request waits for a worker.
+ *   pendingTail    - Newest such client.
+ *   finished       - Clients whose request a worker has answered.
+ *   finishedEvent  - eventfd that wakes the event loop when finished gains a client.
+ *   signalEvent    - signalfd that wakes the event loop on SIGINT or SIGTERM.
+ *   stopping       - Nonzero once the workers should exit.
+ */
+struct server {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	struct serveClient *pendingHead;
+	struct serveClient *pendingTail;
+	struct serveClient *finished;
+	int finishedEvent;
+	int signalEvent;
+	int stopping;
+};
+
+
+
+/*
+* answerRequest(request, forward, backward, out) -- answers one line of the server protocol.
+* request: pointer to a modifiable request line without its newline:
+*          "score NAME", "path NAME", "pair NAME | NAME" or "path NAME | NAME".
+* forward: pointer to the calling thread's forward searchState.
+* backward: pointer to the calling thread's backward searchState.
+* out: pointer to the stream that receives the response.
 * Returns: void.
-* Assumptions: head is either NULL or points to a valid linked list.
-* Side effects: deallocates all nodes in the linked list but does not free actorNode pointers.
+* Assumptions: the graph and the current center's table are ready.
+* Side effects: may modify request; writes the same lines the command line would
+*               print (or an "Error: ..." line) followed by an empty line.
 */
-void freeActorsInMovie(struct actorsInMovie *head) {
-    	while (head != NULL) {
-        	struct actorsInMovie *temp = head;
-        	head = head->next;
-        	free(temp);  // 'to' is not owned — don't free it!
-    	}
+void answerRequest(char *request, struct searchState *forward, struct searchState *backward, FILE *out) {
+
+	char *space = strchr(request, ' ');
+	int printPaths = 0;
+
+	if (space != NULL) {
+		*space = '\0';
+	}
+
+	if (space == NULL || (strcmp(request, "score") != 0 && strcmp(request, "path") != 0
+			&& strcmp(request, "pair") != 0)) {
+		fprintf(out, "Error: Unknown Command.\n");
+	} else if (strcmp(request, "pair") == 0 && strchr(space + 1, '|') == NULL) {
+		fprintf(out, "Error: Pair Needs Two Actors.\n");
+	} else {
+		printPaths = strcmp(request, "path") == 0;
+
+		// The not-found message becomes this protocol's "Error: ..." line, suggestions after it
+		char *errors = NULL;
+		size_t errorsLength = 0;
+		FILE *errOut = open_memstream(&errors, &errorsLength);
+
+		if (errOut == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+		int missing = answerQuery(trimName(space + 1), forward, backward, printPaths, out, errOut) != 0;
+
+		fclose(errOut);
+		if (missing) {
+			fprintf(out, "Error: ");
+			fwrite(errors, 1, errorsLength, out);
+		}
+		free(errors);
+	}
+	fputc('\n', out);
 }
 
 
 
 /*
-* freeActorMovieList(head) -- frees the linked list of movieList nodes belonging to an actor.
-* head: pointer to the first movieList node.
-* Returns: void.
-* Assumptions: head is either NULL or points to a valid linked list.
-* Side effects: deallocates all movieList nodes but does not free movieNode pointers,
-*               as they are managed separately in freeMovieList.
+* serveWorker(arg) -- answers queued server requests until the server stops.
+* arg: pointer to the shared server.
+* Returns: NULL.
+* Assumptions: the graph and the current center's table are ready and no longer change.
+* Side effects: sets up and frees this thread's own pair of search states; moves each
+*               answered client to the finished list and wakes the event loop.
 */
-void freeActorMovieList(struct movieList *head) {
-    	while (head != NULL) {
-        	struct movieList *temp = head;
-        	head = head->next;
-        	// DO NOT free(temp->movie) — not owned, handled in freeMovieList
-        	free(temp);
-    	}
+void* serveWorker(void *arg) {
+
+	struct server *srv = arg;
+	struct searchState forward;
+	struct searchState backward;
+
+	initSearchState(graph, &forward);
+	initSearchState(graph, &backward);
+
+	pthread_mutex_lock(&srv->lock);
+	for (;;) {
+		while (srv->pendingHead == NULL && !srv->stopping) {
+			pthread_cond_wait(&srv->wake, &srv->lock);
+		}
+		if (srv->stopping) {
+			break;
+		}
+
+		struct serveClient *client = srv->pendingHead;
+		srv->pendingHead = client->next;
+		if (srv->pendingHead == NULL) {
+			srv->pendingTail = NULL;
+		}
+		pthread_mutex_unlock(&srv->lock);
+
+		FILE *out = open_memstream(&client->response, &client->responseLength);
+
+		if (out == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+		answerRequest(client->request, &forward, &backward, out);
+		fclose(out);
+
+		uint64_t one = 1;
+		pthread_mutex_lock(&srv->lock);
+		client->next = srv->finished;
+		srv->finished = client;
+		if (write(srv->finishedEvent, &one, sizeof(one)) < 0) {
+			// The counter is already nonzero, so the loop wakes anyway
+		}
+	}
+	pthread_mutex_unlock(&srv->lock);
+
+	freeSearchState(&forward);
+	freeSearchState(&backward);
+	return NULL;
 }
 
 
 
 /*
-* freeActorList(head) -- frees all actorNode structures in the linked list.
-* head: pointer to the first actorNode in the list.
+* freeClient(client) -- closes a client connection and frees its buffers.
+* client: pointer to the serveClient.
 * Returns: void.
-* Assumptions: head is either NULL or points to a valid linked list.
-* Side effects: deallocates all actor nodes, freeing actorName strings and
-*               associated movie lists. Does not free movieNode pointers directly.
+* Assumptions: no worker is answering a request of client.
+* Side effects: closes the socket, which also removes it from the epoll set.
 */
-void freeActorList(struct actorNode *head) {
-    	while (head != NULL) {
-        	struct actorNode *temp = head;
-        	head = head->next;
-        	free(temp->actorName);
-        	freeActorMovieList(temp->movies);  // Correct type now
-        	free(temp);
-    	}
+void freeClient(struct serveClient *client) {
+	close(client->fd);
+	free(client->in);
+	free(client->out);
+	free(client->request);
+	free(client->response);
+	free(client);
 }
 
 
 
 /*
-* freeMovieList(head) -- frees all movieNode structures and their actor lists.
-* head: pointer to the first movieNode in the list.
-* Returns: void.
-* Assumptions: head is either NULL or points to a valid linked list.
-* Side effects: deallocates all movie nodes, freeing movieName strings and
-*               associated actorsInMovie lists. Does not free actorNode pointers.
+* flushClient(client, epollFd) -- sends as much pending response data as the socket takes.
+* client: pointer to the serveClient.
+* epollFd: the server's epoll descriptor.
+* Returns: 0 if the client is still usable, -1 if the connection failed.
+* Assumptions: client->fd is non-blocking.
+* Side effects: advances outSent; waits for EPOLLOUT only while data remains, and for
+*               input only until the peer has shut down its sending side.
 */
-void freeMovieList(struct movieNode *head) {
-    	while (head != NULL) {
-        	struct movieNode *temp = head;
-        	head = head->next;
-        	free(temp->movieName);
-        	freeActorsInMovie(temp->actors);  // Don't free actorNode pointers
-        	free(temp);
-    	}
+int flushClient(struct serveClient *client, int epollFd) {
+
+	while (client->outSent < client->outLength) {
+		ssize_t sent = send(client->fd, client->out + client->outSent,
+			client->outLength - client->outSent, MSG_NOSIGNAL);
+
+		if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (sent < 0 && errno != EINTR) {
+			return -1;
+		}
+		if (sent > 0) {
+			client->outSent += sent;
+		}
+	}
+
+	if (client->outSent == client->outLength) {
+		client->outSent = client->outLength = 0;
+	}
+
+	// A finished input stays readable forever, so stop watching it; edge triggering keeps
+	// a hang-up, which cannot be masked, from waking the loop more than once
+	struct epoll_event event;
+	event.events = (client->inputDone ? EPOLLET : EPOLLIN | EPOLLRDHUP) | (client->outLength > 0 ? EPOLLOUT : 0);
+	event.data.ptr = client;
+	epoll_ctl(epollFd, EPOLL_CTL_MOD, client->fd, &event);
+	return 0;
 }
 
 
 
 /*
-* printActorsWithMovies() -- prints a list of all movies and their associated actors.
+* dispatchClient(srv, client) -- hands a client's next complete request line to the workers.
+* srv: pointer to the server.
+* client: pointer to an idle serveClient.
 * Returns: void.
-* Assumptions: headMovies points to a valid linked list of movieNode structures.
-* Side effects: outputs movie names and their actor lists to standard output.
-* Note: This function is primarily used for debugging and verifying movie-actor relationships.
+* Assumptions: called by the event loop only.
+* Side effects: removes the line from client->in and queues the client; does nothing
+*               if no complete line has arrived yet. Once the peer's input is done,
+*               an unterminated last line counts as complete. One request per client
+*               is in flight at a time, so responses come back in request order.
 */
-void printActorsWithMovies() {
+void dispatchClient(struct server *srv, struct serveClient *client) {
 
-    struct movieNode *curMovie = headMovies;
+	char *newline = memchr(client->in, '\n', client->inLength);
 
-    while (curMovie != NULL) {
-	
-	    printf("MOVIE: %s\n", curMovie->movieName);
+	if (client->request != NULL || (newline == NULL && (!client->inputDone || client->inLength == 0))) {
+		return;
+	}
 
-	    struct actorsInMovie *curActor = curMovie->actors;
+	size_t lineLength = newline != NULL ? (size_t) (newline - client->in) : client->inLength;
+	client->request = malloc(lineLength + 1);
+
+	if (client->request == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	memcpy(client->request, client->in, lineLength);
+	client->request[lineLength] = '\0';
+	if (lineLength > 0 && client->request[lineLength - 1] == '\r') {
+		client->request[lineLength - 1] = '\0';
+	}
+	client->inLength -= newline != NULL ? lineLength + 1 : lineLength;
+	if (newline != NULL) {
+		memmove(client->in, newline + 1, client->inLength);
+	}
 
-	    while (curActor != NULL) {
-		    printf("	ACTOR: %s\n", curActor->to->actorName);
-	    	    curActor = curActor->next;
-	    }
-	    curMovie = curMovie->next;
-    }
+	pthread_mutex_lock(&srv->lock);
+	client->next = NULL;
+	if (srv->pendingTail != NULL) {
+		srv->pendingTail->next = client;
+	} else {
+		srv->pendingHead = client;
+	}
+	srv->pendingTail = client;
+	pthread_cond_signal(&srv->wake);
+	pthread_mutex_unlock(&srv->lock);
 }
 
 
 
 /*
-* freeQueue(head) -- frees all queue nodes in a linked list queue structure.
-* head: pointer to the first queue node.
+* advanceClient(srv, client) -- moves an idle client on to its next request.
+* srv: pointer to the server.
+* client: pointer to an idle, open serveClient.
 * Returns: void.
-* Assumptions: head is either NULL or points to a valid queue linked list.
-* Side effects: deallocates all queue nodes but does not free actorNode pointers.
+* Assumptions: called by the event loop only.
+* Side effects: queues the client's next request if one has arrived; marks the client
+*               closed once its input is done and every answer has been sent.
 */
-void freeQueue(struct queue *head) {
-    while (head != NULL) {
-        struct queue *temp = head;
-        head = head->next;
-        free(temp);
-    }
+void advanceClient(struct server *srv, struct serveClient *client) {
+
+	dispatchClient(srv, client);
+
+	if (client->inputDone && client->request == NULL && client->outLength == 0) {
+		client->closed = 1;
+	}
 }
 
 
 
 /*
-* BFS(start, target) -- performs Breadth-First Search to find the shortest path 
-*                        (in terms of degrees of separation) between two actors.
-* start: pointer to the actorNode representing the starting actor.
-* target: pointer to the actorNode representing the target actor.
-* Returns: the shortest path length (number of connections) or -1 if no path exists.
-* Assumptions: headActors is a valid pointer to the global linked list of actors.
-* Side effects: modifies actorNode fields (visited and level) and dynamically allocates 
-*               memory for the queue, which is freed before returning.
+* readClient(client) -- reads whatever a client has sent.
+* client: pointer to the serveClient.
+* Returns: 0 if the connection is still usable, -1 if it failed or the peer sent a
+*          line longer than SERVE_MAX_LINE.
+* Assumptions: client->fd is non-blocking.
+* Side effects: appends the received bytes to client->in, growing it as needed; sets
+*               inputDone at end of input, since a peer that shuts down its sending
+*               side (nc -N, a file piped into socat) still waits for its answers.
 */
-int BFS(struct actorNode *start, struct actorNode *target) {
-    
-	if (start == target) {
-		return 0;
+int readClient(struct serveClient *client) {
+
+	for (;;) {
+		if (client->inLength == client->inCapacity) {
+			if (client->inCapacity >= SERVE_MAX_LINE && memchr(client->in, '\n', client->inLength) == NULL) {
+				return -1;
+			}
+			client->inCapacity = client->inCapacity == 0 ? 1024 : client->inCapacity * 2;
+			client->in = realloc(client->in, client->inCapacity);
+
+			if (client->in == NULL) {
+				fprintf(stderr, "Not Enough Memory.\n");
+				exit(1);
+			}
+		}
+
+		ssize_t got = recv(client->fd, client->in + client->inLength, client->inCapacity - client->inLength, 0);
+
+		if (got > 0) {
+			client->inLength += got;
+		} else if (got == 0) {
+			client->inputDone = 1;
+			return 0;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return 0;
+		} else if (errno != EINTR) {
+			return -1;
+		}
 	}
+}
 
-    	// Clear all visited and levels
-    	struct actorNode *cur = headActors;
-    	while (cur != NULL) {
-        	cur->visited = 0;
-        	cur->level = -1;
-        	cur = cur->next;
-    	}
-
-    	struct queue *q = NULL;
-    	start->visited = 1;
-    	start->level = 0;
-    	enqueue(&q, start);
-
-    	while (q != NULL) {
-        	struct actorNode *a = dequeue(&q);
-
-        	// Loop over all movies this actor is in
-        	struct movieList *ml = a->movies;
-        	while (ml != NULL) {
-            		struct movieNode *movie = ml->movie;
-
-            		// Loop over all actors in this movie
-            		struct actorsInMovie *co = movie->actors;
-            		while (co != NULL) {
-                		struct actorNode *c = co->to;
-
-                		if (!c->visited) {
-                    			c->visited = 1;
-                    			c->level = a->level + 1;
-
-                    			if (c == target) {
-                        			freeQueue(q);
-						return c->level;
-                    			}
-                    			enqueue(&q, c);
-                		}
-
-                		co = co->next;
-            		}
-            		ml = ml->next;
-        	}
-    	}
-	freeQueue(q);
-    	return -1; // Not found
+
+
+/*
+* runServer(path) -- serves queries on a Unix domain socket until SIGINT or SIGTERM.
+* path: pointer to a string containing the socket's path.
+* Returns: 0 after a clean shutdown, 1 if the socket could not be set up.
+* Assumptions: the graph and the current center's table are ready.
+* Side effects: creates the socket file (replacing a stale one) and removes it on
+*               exit; starts workerThreads workers (one per CPU by default); blocks
+*               SIGINT and SIGTERM while serving.
+*
+* One thread runs an epoll loop that accepts clients, reads their request lines and
+* writes back responses; the workers only answer queries. Each client has at most
+* one request with the workers, so responses keep the order of its requests while
+* different clients are answered in parallel. SIGINT and SIGTERM stay blocked and
+* arrive through a signalfd in the same epoll set, so a signal can never slip in
+* between checking for it and going to sleep.
+*/
+int runServer(const char *path) {
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "Socket Path Too Long.\n");
+		return 1;
+	}
+	strcpy(address.sun_path, path);
+
+	int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	unlink(path);
+
+	if (listenFd < 0 || bind(listenFd, (struct sockaddr *) &address, sizeof(address)) != 0
+			|| listen(listenFd, SOMAXCONN) != 0) {
+		fprintf(stderr, "Could not Open the Socket.\n");
+		if (listenFd >= 0) {
+			close(listenFd);
+		}
+		return 1;
+	}
+
+	struct server srv;
+	pthread_mutex_init(&srv.lock, NULL);
+	pthread_cond_init(&srv.wake, NULL);
+	srv.pendingHead = srv.pendingTail = srv.finished = NULL;
+	srv.stopping = 0;
+	srv.finishedEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	// Blocked before the workers start, so they inherit the mask and only the signalfd sees these
+	sigset_t stopSignals;
+	sigset_t oldMask;
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &stopSignals, &oldMask);
+	srv.signalEvent = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+	int epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+	if (srv.finishedEvent < 0 || srv.signalEvent < 0 || epollFd < 0) {
+		fprintf(stderr, "Could not Open the Socket.\n");
+		pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+		close(listenFd);
+		unlink(path);
+		return 1;
+	}
+
+	// The listening socket, the eventfd and the signalfd are told apart by their tags:
+	// NULL, srv and srv.signalEvent; any other tag is a client
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+	event.data.ptr = &srv;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, srv.finishedEvent, &event);
+	event.data.ptr = &srv.signalEvent;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, srv.signalEvent, &event);
+
+	long threads = workerThreads > 0 ? workerThreads : sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	pthread_t *workers = calloc(threads, sizeof(pthread_t));
+	int *started = calloc(threads, sizeof(int));
+
+	if (workers == NULL || started == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	long running = 0;
+	for (long index = 0; index < threads; index++) {
+		started[index] = pthread_create(&workers[index], NULL, serveWorker, &srv) == 0;
+		running += started[index];
+	}
+
+	// Every connected client, so they can all be freed on shutdown
+	struct serveClient **clients = NULL;
+	size_t numClients = 0;
+	size_t clientsCapacity = 0;
+	struct epoll_event events[64];
+	int stop = 0;
+	int acceptPaused = 0;
+	double pausedAt = 0;
+
+	while (!stop && running > 0) {
+		int ready = epoll_wait(epollFd, events, 64, acceptPaused ? SERVE_ACCEPT_RETRY_MS : -1);
+
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		// Out of descriptors a while ago: try the clients still waiting in the backlog again
+		if (acceptPaused && clockSeconds() - pausedAt >= SERVE_ACCEPT_RETRY_MS / 1e3) {
+			event.events = EPOLLIN;
+			event.data.ptr = NULL;
+			epoll_ctl(epollFd, EPOLL_CTL_MOD, listenFd, &event);
+			acceptPaused = 0;
+		}
+
+		for (int index = 0; index < ready; index++) {
+
+			if (events[index].data.ptr == &srv.signalEvent) {
+				struct signalfd_siginfo info;
+				if (read(srv.signalEvent, &info, sizeof(info)) < 0) {
+					// Nothing to drain; stopping is all that matters
+				}
+				stop = 1;
+				continue;
+			}
+
+			if (events[index].data.ptr == NULL) {
+				for (;;) {
+					int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+					if (fd < 0) {
+						if (errno == EINTR || errno == ECONNABORTED) {
+							continue;
+						}
+
+						// Out of descriptors or memory: the listener stays readable, so stop
+						// watching it for a while instead of spinning on it
+						if (errno != EAGAIN && errno != EWOULDBLOCK) {
+							event.events = 0;
+							event.data.ptr = NULL;
+							epoll_ctl(epollFd, EPOLL_CTL_MOD, listenFd, &event);
+							acceptPaused = 1;
+							pausedAt = clockSeconds();
+						}
+						break;
+					}
+
+					if (numClients == clientsCapacity) {
+						clientsCapacity = clientsCapacity == 0 ? 64 : clientsCapacity * 2;
+						clients = realloc(clients, clientsCapacity * sizeof(struct serveClient *));
+					}
+					struct serveClient *client = calloc(1, sizeof(struct serveClient));
+
+					if (client == NULL || clients == NULL) {
+						fprintf(stderr, "Not Enough Memory.\n");
+						exit(1);
+					}
+					client->fd = fd;
+					clients[numClients++] = client;
+
+					struct epoll_event clientEvent;
+					clientEvent.events = EPOLLIN | EPOLLRDHUP;
+					clientEvent.data.ptr = client;
+					epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &clientEvent);
+				}
+				continue;
+			}
+
+			if (events[index].data.ptr == &srv) {
+				uint64_t count;
+				if (read(srv.finishedEvent, &count, sizeof(count)) < 0) {
+					// Already drained by an earlier wakeup
+				}
+
+				pthread_mutex_lock(&srv.lock);
+				struct serveClient *done = srv.finished;
+				srv.finished = NULL;
+				pthread_mutex_unlock(&srv.lock);
+
+				while (done != NULL) {
+					struct serveClient *client = done;
+					done = client->next;
+
+					free(client->request);
+					client->request = NULL;
+
+					if (!client->closed) {
+						if (client->outLength + client->responseLength > 0) {
+							client->out = realloc(client->out, client->outLength + client->responseLength);
+
+							if (client->out == NULL) {
+								fprintf(stderr, "Not Enough Memory.\n");
+								exit(1);
+							}
+						}
+						memcpy(client->out + client->outLength, client->response, client->responseLength);
+						client->outLength += client->responseLength;
+						client->closed = flushClient(client, epollFd) != 0;
+					}
+					free(client->response);
+					client->response = NULL;
+
+					if (!client->closed) {
+						advanceClient(&srv, client);
+					}
+				}
+				continue;
+			}
+
+			struct serveClient *client = events[index].data.ptr;
+
+			if (client->closed) {
+				continue;
+			}
+			if ((events[index].events & EPOLLOUT) && client->outLength > 0 && flushClient(client, epollFd) != 0) {
+				client->closed = 1;
+			}
+
+			// At end of input, flushClient also stops watching the input
+			if (!client->closed && !client->inputDone
+					&& (events[index].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+				client->closed = readClient(client) != 0 || (client->inputDone && flushClient(client, epollFd) != 0);
+			}
+			if (!client->closed) {
+				advanceClient(&srv, client);
+			}
+			if (client->closed) {
+				epoll_ctl(epollFd, EPOLL_CTL_DEL, client->fd, NULL);
+			}
+		}
+
+		// Closed clients are freed once no worker holds their request
+		size_t kept = 0;
+		for (size_t index = 0; index < numClients; index++) {
+			struct serveClient *client = clients[index];
+
+			if (client->closed && client->request == NULL) {
+				freeClient(client);
+			} else {
+				clients[kept++] = client;
+			}
+		}
+
+		// A freed client gave back a descriptor, so accepting may work again
+		if (kept < numClients && acceptPaused) {
+			event.events = EPOLLIN;
+			event.data.ptr = NULL;
+			epoll_ctl(epollFd, EPOLL_CTL_MOD, listenFd, &event);
+			acceptPaused = 0;
+		}
+		numClients = kept;
+	}
+
+	pthread_mutex_lock(&srv.lock);
+	srv.stopping = 1;
+	pthread_cond_broadcast(&srv.wake);
+	pthread_mutex_unlock(&srv.lock);
+
+	for (long index = 0; index < threads; index++) {
+		if (started[index]) {
+			pthread_join(workers[index], NULL);
+		}
+	}
+	free(workers);
+	free(started);
+
+	for (size_t index = 0; index < numClients; index++) {
+		freeClient(clients[index]);
+	}
+	free(clients);
+	close(epollFd);
+	close(srv.finishedEvent);
+	close(srv.signalEvent);
+	pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+	close(listenFd);
+	unlink(path);
+	pthread_cond_destroy(&srv.wake);
+	pthread_mutex_destroy(&srv.lock);
+	return 0;
+}
+
+
+
+
+/*
+* runReport(in) -- prints distance statistics for every center actor listed in a stream.
+* in: pointer to the stream of center names, one per line.
+* Returns: 1 if any center could not be found, otherwise 0.
+* Assumptions: the graph is ready.
+* Side effects: reads in to the end and prints one summary line per center to
+*               standard output (or a not-found error to standard error), in
+*               input order; centers are searched MSBFS_WIDTH at a time.
+*/
+int runReport(FILE *in) {
+
+	uint32_t *centers = NULL;
+	size_t numCenters = 0;
+	size_t centersCapacity = 0;
+
+	char *line = NULL;
+	size_t len = 0;
+	ssize_t got;
+
+	while ((got = getline(&line, &len, in)) > 0) {
+
+		if (line[got - 1] == '\n') {
+			line[--got] = '\0';
+		}
+
+		if (numCenters == centersCapacity) {
+			centersCapacity = centersCapacity == 0 ? 1024 : centersCapacity * 2;
+			centers = realloc(centers, centersCapacity * sizeof(uint32_t));
+
+			if (centers == NULL) {
+				fprintf(stderr, "Not Enough Memory.\n");
+				exit(1);
+			}
+		}
+		centers[numCenters++] = lookupActor(graph, line, got);
+	}
+	free(line);
+
+	// Unknown centers keep their place in the output but are not searched
+	uint32_t lanes[MSBFS_WIDTH];
+	struct centerStats stats[MSBFS_WIDTH];
+	int errSeen = 0;
+	size_t index = 0;
+
+	while (index < numCenters) {
+		size_t first = index;
+		uint32_t count = 0;
+
+		for (; index < numCenters && count < MSBFS_WIDTH; index++) {
+			if (centers[index] != NO_ACTOR) {
+				lanes[count++] = centers[index];
+			}
+		}
+
+		multiSourceBFS(graph, lanes, count, stats);
+
+		uint32_t lane = 0;
+		for (size_t center = first; center < index; center++) {
+			if (centers[center] == NO_ACTOR) {
+				errSeen = 1;
+				fflush(stdout);
+				fprintf(stderr, "Actor Could Not be Found.\n");
+				continue;
+			}
+
+			printName(graph, stdout, graph->actorNames[lanes[lane]]);
+			printf(": reachable %llu, average %.3f, eccentricity %u\n",
+				(unsigned long long) stats[lane].reachable,
+				stats[lane].reachable > 0 ? (double) stats[lane].totalDistance / stats[lane].reachable : 0.0,
+				stats[lane].eccentricity);
+			lane++;
+		}
+	}
+	free(centers);
+	return errSeen;
 }
 
 
@@ -671,13 +1780,22 @@ int BFS(struct actorNode *start, struct actorNode *target) {
 * argv: array of strings representing the command-line arguments.
 * Returns: 0 on successful execution, 1 if errors occur (file issues, invalid actors).
 * Assumptions: argv[1] contains a valid filename; input format follows expected structure.
-* Side effects: allocates memory for actors and movies, modifies global linked lists,
-*               dynamically reads from stdin, and frees allocated resources before exiting.
+* Side effects: opens the graph through the library, dynamically
+*               reads from stdin, and frees allocated resources before exiting.
 */
 int main(int argc, char* argv[]) {
 
-	FILE *file; 
+	char *fileName = NULL;
+	char *saveSnapshotName = NULL;
+	char *loadSnapshotName = NULL;
+	char *batchName = NULL;
+	char *reportName = NULL;
+	char *centerName = NULL;
+	char *labelIndexName = NULL;
+	char *serveName = NULL;
 	int minusOption = 0;
+	int statsOption = 0;
+	int latencyOption = 0;
 
 	int errSeen = 0;
 
@@ -692,9 +1810,75 @@ int main(int argc, char* argv[]) {
 				fprintf(stderr, "Too many optional Arguments.\n");
 				return 1;
 			}
+		} else if (strcmp("--stats", argv[index]) == 0) {
+			statsOption = 1;
+		} else if (strcmp("--latency", argv[index]) == 0) {
+			latencyOption = 1;
+		} else if (strcmp("--suggest", argv[index]) == 0) {
+			if (index + 1 == argc || (suggestCount = strtol(argv[index + 1], NULL, 10)) < 1
+					|| suggestCount > MAX_SUGGESTIONS) {
+				fprintf(stderr, "Invalid Suggestion Count.\n");
+				return 1;
+			}
+			index++;
+		} else if (strcmp("--threads", argv[index]) == 0) {
+			if (index + 1 == argc || (workerThreads = strtol(argv[index + 1], NULL, 10)) < 1) {
+				fprintf(stderr, "Invalid Thread Count.\n");
+				return 1;
+			}
+			index++;
+		} else if (strcmp("--batch", argv[index]) == 0) {
+			if (index + 1 == argc) {
+				fprintf(stderr, "Missing Batch File.\n");
+				return 1;
+			}
+			batchName = argv[++index];
+		} else if (strcmp("--report", argv[index]) == 0) {
+			if (index + 1 == argc) {
+				fprintf(stderr, "Missing Report File.\n");
+				return 1;
+			}
+			reportName = argv[++index];
+		} else if (strcmp("--center", argv[index]) == 0) {
+			if (index + 1 == argc) {
+				fprintf(stderr, "Missing Center Actor.\n");
+				return 1;
+			}
+			centerName = argv[++index];
+		} else if (strcmp("--label-index", argv[index]) == 0) {
+			if (index + 1 == argc) {
+				fprintf(stderr, "Missing Label Index File.\n");
+				return 1;
+			}
+			labelIndexName = argv[++index];
+		} else if (strcmp("--serve", argv[index]) == 0) {
+			if (index + 1 == argc) {
+				fprintf(stderr, "Missing Socket Path.\n");
+				return 1;
+			}
+			serveName = argv[++index];
+		} else if (strcmp("--center-cache", argv[index]) == 0) {
+			long megabytes;
+
+			if (index + 1 == argc || (megabytes = strtol(argv[index + 1], NULL, 10)) < 0) {
+				fprintf(stderr, "Invalid Cache Size.\n");
+				return 1;
+			}
+			centerCacheBudget = (size_t) megabytes << 20;
+			index++;
+		} else if (strcmp("--save-snapshot", argv[index]) == 0 || strcmp("--load-snapshot", argv[index]) == 0) {
+			if (index + 1 == argc) {
+				fprintf(stderr, "Missing Snapshot File for %s.\n", argv[index]);
+				return 1;
+			}
+			if (argv[index][2] == 's') {
+				saveSnapshotName = argv[++index];
+			} else {
+				loadSnapshotName = argv[++index];
+			}
 		} else {
 			if (!fileNotInit) {
-				file = fopen(argv[index], "r");
+				fileName = argv[index];
 				fileNotInit++;
 			} else {
 				fprintf(stderr, "Too many Files were given.\n");
@@ -703,50 +1887,143 @@ int main(int argc, char* argv[]) {
 		}
 	}
 
-	minusOption++;
-	
-	if (file == NULL) {
+	// SIGUSR1 prints the latency histograms; block it before any thread starts so
+	// that only the thread waiting for it receives it. That thread starts with every
+	// signal blocked, so SIGINT and SIGTERM reach --serve's signalfd instead of it.
+	sigset_t latencySignals;
+	sigset_t allSignals;
+	sigset_t mainMask;
+	pthread_t latencyThread;
+
+	sigemptyset(&latencySignals);
+	sigaddset(&latencySignals, SIGUSR1);
+	sigfillset(&allSignals);
+	pthread_sigmask(SIG_BLOCK, &latencySignals, NULL);
+	pthread_sigmask(SIG_SETMASK, &allSignals, &mainMask);
+	if (pthread_create(&latencyThread, NULL, latencySignalThread, NULL) == 0) {
+		pthread_detach(latencyThread);
+	}
+	pthread_sigmask(SIG_SETMASK, &mainMask, NULL);
+
+	if (loadSnapshotName != NULL) {
+		if (fileName != NULL) {
+			fprintf(stderr, "Too many Files were given.\n");
+			return 1;
+		}
+		if ((graph = bacon_open_snapshot(loadSnapshotName, workerThreads)) == NULL) {
+			fprintf(stderr, "Could not Load the Snapshot.\n");
+			return 1;
+		}
+	} else if (fileName == NULL || (graph = bacon_open(fileName, workerThreads)) == NULL) {
 		fprintf(stderr, "Could not Open the File.\n");
 		return 1;
 	}
+	initSearchState(graph, &forwardSearch);
+	initSearchState(graph, &backwardSearch);
+
+	if (suggestCount > 0) {
+		buildTrigrams(graph);
+	}
+
+	// Reuse the label index when it matches this graph, otherwise build and store it
+	if (labelIndexName != NULL && loadLabels(graph, labelIndexName) != 0) {
+		if (buildLabels(graph) != 0) {
+			fprintf(stderr, "Could not Build the Label Index.\n");
+			errSeen = 1;
+		} else if (saveLabels(graph, labelIndexName) != 0) {
+			fprintf(stderr, "Could not Write the Label Index.\n");
+			errSeen = 1;
+		}
+	}
 
-	parseFile(file);
+	// A snapshot's table is reused as is when it belongs to the chosen center
+	if (graph->snapshotCenter != NO_ACTOR) {
+		addMappedCenter();
+	}
+
+	// The center only changes on "@center", so answer every query from one full BFS
+	uint32_t center = centerName != NULL ? lookupActor(graph, centerName, strlen(centerName))
+		: lookupActor(graph, "Kevin Bacon", strlen("Kevin Bacon"));
+
+	if (centerName != NULL && center == NO_ACTOR) {
+		fprintf(stderr, "Center Could Not be Found.\n");
+		freeCenterCache();
+		freeSearchState(&forwardSearch);
+		freeSearchState(&backwardSearch);
+		bacon_close(graph);
+		return 1;
+	}
+	useCenter(center);
+
+	if (saveSnapshotName != NULL && saveSnapshot(graph, saveSnapshotName, baconActor, baconDistances, baconParents, baconParentMovies) != 0) {
+		fprintf(stderr, "Could not Write the Snapshot.\n");
+		errSeen = 1;
+	}
 	
+	// Serving or a report replaces the query loop; a batch file, or queries
+	// piped in rather than typed, are answered all at once
+	if (serveName != NULL) {
+		errSeen |= runServer(serveName);
+	} else if (reportName != NULL) {
+		FILE *report = fopen(reportName, "r");
+
+		if (report == NULL) {
+			fprintf(stderr, "Could not Open the Report File.\n");
+			errSeen = 1;
+		} else {
+			errSeen |= runReport(report);
+			fclose(report);
+		}
+	} else if (batchName != NULL) {
+		FILE *batch = fopen(batchName, "r");
+
+		if (batch == NULL) {
+			fprintf(stderr, "Could not Open the Batch File.\n");
+			errSeen = 1;
+		} else {
+			errSeen |= runBatch(batch, minusOption);
+			fclose(batch);
+		}
+	} else if (!isatty(STDIN_FILENO)) {
+		errSeen |= runBatch(stdin, minusOption);
+	}
+
 	char *actorName = NULL;
 	size_t len = 0;
-	struct actorNode *actor;
 
-	while ((getline(&actorName, &len, stdin)) > 0) {
+	while (batchName == NULL && reportName == NULL && serveName == NULL && (getline(&actorName, &len, stdin)) > 0) {
 
 		if (actorName[strlen(actorName) - 1] == '\n') {
 			actorName[strlen(actorName) - 1] = '\0';
         	}
 
-		if ((actor = findActor(actorName)) == NULL) {
-			errSeen = 1;
-			fprintf(stderr, "Actor Could Not be Found.\n");
-			continue;
-		}
-
-		struct actorNode *bacon = findActor("Kevin Bacon");
+		char *switchTo = centerCommand(actorName);
 
-		// No Bacon in Graph, Dont have to check it.
-		if (bacon == NULL) {
-			printf("Score: No Bacon!\n");
-			continue;
-		}
+		if (switchTo != NULL) {
+			switchTo = trimName(switchTo);
+			uint32_t newCenter = lookupActor(graph, switchTo, strlen(switchTo));
 
-		int bfs = BFS(bacon, actor);
-	
-		if (bfs == -1) {
-			printf("Score: No Bacon!\n");
-		} else {
-			printf("Score: %d\n", bfs);
+			if (newCenter == NO_ACTOR) {
+				errSeen = 1;
+				fprintf(stderr, "Actor Could Not be Found.\n");
+			} else {
+				useCenter(newCenter);
+			}
+		} else if (answerQuery(actorName, &forwardSearch, &backwardSearch, minusOption, stdout, stderr) != 0) {
+			errSeen = 1;
 		}
 	}
 	free(actorName);
-	freeActorList(headActors);
-	freeMovieList(headMovies);
-	fclose(file);
+
+	if (statsOption) {
+		printStats(stderr);
+	}
+	if (latencyOption) {
+		printLatencies(stderr);
+	}
+	freeCenterCache();
+	freeSearchState(&forwardSearch);
+	freeSearchState(&backwardSearch);
+	bacon_close(graph);
 	return errSeen;
 }
@@ -0,0 +1,3591 @@
+/*
+* File: bacon.c
+* Author: Chance Krueger
+*
+* Purpose:
+*   The Bacon graph library behind BaconScore and bacon.h. It parses a dataset
+*   of movie-actor relationships into a graph where actors are nodes and
+*   shared movies connect them, and answers Breadth-First Searches over it.
+*
+*   Everything that belongs to one dataset lives in its bacon_graph, and all
+*   scratch state of a search lives in a searchState, so one loaded graph can
+*   be searched from many threads at once.
+*/
+
+
+
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bacon_internal.h"
+
+
+
+/*
+* clockSeconds() -- reads the monotonic clock.
+* Returns: the current time in seconds from an arbitrary start.
+* Assumptions: none.
+* Side effects: none.
+*/
+double clockSeconds() {
+
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+
+
+/*
+* growQueue(q, capacity) -- resizes a queue's ring buffer, keeping its entries in order.
+* q: pointer to the queue.
+* capacity: new capacity, a power of two no smaller than q->count.
+* Returns: void.
+* Assumptions: q is a valid queue.
+* Side effects: reallocates q->items and unwraps the queued entries to start at 0.
+*/
+void growQueue(struct queue *q, size_t capacity) {
+    uint32_t *items = malloc(capacity * sizeof(uint32_t));
+
+    if (items == NULL) {
+        fprintf(stderr, "Not Enough Memory.\n");
+        exit(1);
+    }
+
+    for (size_t index = 0; index < q->count; index++) {
+        items[index] = q->items[(q->head + index) & (q->capacity - 1)];
+    }
+    free(q->items);
+    q->items = items;
+    q->capacity = capacity;
+    q->head = 0;
+}
+
+
+
+/*
+* dequeue(q) -- removes and returns the front actor ID from the queue.
+* q: pointer to the queue.
+* Returns: the dequeued actor ID.
+* Assumptions: q is a valid, non-empty queue.
+* Side effects: advances the head of the ring buffer.
+*/
+uint32_t dequeue(struct queue *q) {
+    uint32_t node = q->items[q->head];
+    q->head = (q->head + 1) & (q->capacity - 1);  // Move the head to the next element
+    q->count--;
+    return node;
+}
+
+
+
+/*
+* enqueue(q, actor) -- appends an actor ID at the tail of the queue.
+* q: pointer to the queue.
+* actor: ID of the actor to enqueue.
+* Returns: void.
+* Assumptions: q is a valid queue.
+* Side effects: doubles the ring buffer when it is full; otherwise allocates nothing.
+*/
+void enqueue(struct queue *q, uint32_t actor) {
+    if (q->count == q->capacity) {
+        growQueue(q, q->capacity == 0 ? 1024 : q->capacity * 2);
+    }
+    q->items[(q->head + q->count) & (q->capacity - 1)] = actor;
+    q->count++;
+}
+
+
+
+/*
+* resetQueue(q) -- empties the queue while keeping its buffer for reuse.
+* q: pointer to the queue.
+* Returns: void.
+* Assumptions: q is a valid queue.
+* Side effects: resets head and count.
+*/
+void resetQueue(struct queue *q) {
+    q->head = 0;
+    q->count = 0;
+}
+
+
+/*
+* freeQueue(q) -- frees the ring buffer of a queue.
+* q: pointer to the queue.
+* Returns: void.
+* Assumptions: q is a valid queue.
+* Side effects: deallocates q->items and leaves q empty with no capacity.
+*/
+void freeQueue(struct queue *q) {
+    free(q->items);
+    q->items = NULL;
+    q->capacity = 0;
+    resetQueue(q);
+}
+
+
+/*
+* arenaAlloc(arena, size, align) -- carves size bytes out of an arena.
+* arena: pointer to the arena.
+* size: number of bytes needed.
+* align: required alignment, a power of two.
+* Returns: pointer to the bytes, which start out zeroed since blocks are fresh
+*          anonymous mappings and are never reused.
+* Assumptions: arena is valid (all-NULL when empty).
+* Side effects: advances the cursor; maps a new block when the current one is full.
+*/
+void* arenaAlloc(struct arena *arena, size_t size, size_t align) {
+
+	uintptr_t cursor = ((uintptr_t) arena->cursor + align - 1) & ~(uintptr_t) (align - 1);
+
+	if (arena->cursor == NULL || cursor + size > (uintptr_t) arena->end) {
+		size_t header = (sizeof(struct arenaBlock) + 15) & ~(size_t) 15;
+		size_t blockSize = ARENA_BLOCK_SIZE;
+
+		if (header + size + align > blockSize) {
+			blockSize = header + size + align;
+		}
+
+		struct arenaBlock *block = mmap(NULL, blockSize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (block == MAP_FAILED) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+
+		block->next = arena->blocks;
+		block->size = blockSize;
+		arena->blocks = block;
+		arena->cursor = (char *) block + header;
+		arena->end = (char *) block + blockSize;
+		cursor = ((uintptr_t) arena->cursor + align - 1) & ~(uintptr_t) (align - 1);
+	}
+
+	arena->cursor = (char *) (cursor + size);
+	return (void *) cursor;
+}
+
+
+
+/*
+* freeArena(arena) -- releases every block of an arena.
+* arena: pointer to the arena.
+* Returns: void.
+* Assumptions: nothing allocated from arena is used afterwards.
+* Side effects: unmaps all blocks and leaves arena empty.
+*/
+void freeArena(struct arena *arena) {
+	while (arena->blocks != NULL) {
+		struct arenaBlock *block = arena->blocks;
+		arena->blocks = block->next;
+		munmap(block, block->size);
+	}
+	arena->cursor = NULL;
+	arena->end = NULL;
+}
+
+
+
+/*
+* findMovie(line, end) -- locates the movie title in a formatted input line.
+* line: pointer to the first character of a movie entry (e.g., "Movie: Title").
+* end: pointer one past the last character of the line.
+* Returns: a pointer into line at the start of the title, with the prefix skipped.
+* Assumptions: the line contains a ':' separating "Movie" from the title.
+* Side effects: none.
+*/
+const char* findMovie(const char *line, const char *end) {
+
+	const char *movie = memchr(line, ':', end - line);
+
+	// GET RID OF SPACE BEFORE ':'
+	movie++;
+	if (movie < end) {
+		movie++;
+	}
+	return movie;
+}
+
+
+/*
+* containsMovie(line, end) -- determines whether an input line contains a movie entry.
+* line: pointer to the first character of a movie or actor entry.
+* end: pointer one past the last character of the line.
+* Returns: 1 if the line contains a movie identifier (":"), otherwise 0.
+* Assumptions: line and end delimit one line of the input text.
+* Side effects: none.
+*/
+int containsMovie(const char *line, const char *end) {
+	return memchr(line, ':', end - line) != NULL;
+}
+
+
+
+/*
+* printName(g, out, name) -- writes an actor or movie name to a stream.
+* g: pointer to the graph.
+* out: pointer to the output stream.
+* name: view of the name inside nameBase.
+* Returns: void.
+* Assumptions: name refers to the loaded input text.
+* Side effects: writes to out.
+*/
+void printName(const struct bacon_graph *g, FILE *out, struct nameRef name) {
+	fwrite(g->nameBase + name.offset, 1, name.length, out);
+}
+
+
+
+/*
+* addAppearance(g, actor, movie, lastMovie) -- records that an actor appears in a movie.
+* g: pointer to the graph.
+* actor: ID of the actor.
+* movie: ID of the movie.
+* lastMovie: per-actor ID of the last movie recorded for that actor.
+* Returns: void.
+* Assumptions: both IDs are registered; a movie's cast is parsed contiguously, so a
+*              repeat of the same movie for an actor is always its last recorded one.
+* Side effects: appends to the appearances array, growing it as needed, and
+*               updates lastMovie, ensuring no duplicate actors are added.
+*/
+void addAppearance(struct bacon_graph *g, uint32_t actor, uint32_t movie, uint32_t *lastMovie) {
+
+	// COPY, DONT ADD
+	if (lastMovie[actor] == movie) {
+		return;
+	}
+	lastMovie[actor] = movie;
+
+	if (g->numAppearances == g->appearancesCapacity) {
+		g->appearancesCapacity = g->appearancesCapacity == 0 ? 4096 : g->appearancesCapacity * 2;
+		g->appearances = realloc(g->appearances, g->appearancesCapacity * sizeof(struct appearance));
+
+		if (g->appearances == NULL) {
+			fprintf(stderr, "Not Enough Space.\n");
+			exit(1);
+		}
+	}
+
+	g->appearances[g->numAppearances].actor = actor;
+	g->appearances[g->numAppearances].movie = movie;
+	g->numAppearances++;
+}
+
+
+
+/*
+* hashName(name, length) -- computes the 64-bit FNV-1a hash of a name.
+* name: pointer to the first byte of the name.
+* length: length of the name in bytes.
+* Returns: the hash value.
+* Assumptions: name points to at least length readable bytes.
+* Side effects: none.
+*/
+uint64_t hashName(const char *name, size_t length) {
+
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (size_t index = 0; index < length; index++) {
+		hash ^= (unsigned char) name[index];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+
+/*
+* probeActor(g, actor, length, hash) -- finds the slot of an actor name in the actor hash table.
+* g: pointer to the graph.
+* actor: pointer to the first byte of the actor's name.
+* length: length of the name in bytes.
+* hash: hashName of the name.
+* Returns: the index of the slot holding the actor, or of the empty slot where
+*          it would be inserted.
+* Assumptions: actorSlots is allocated and has at least one empty slot.
+* Side effects: none.
+*/
+size_t probeActor(const struct bacon_graph *g, const char *actor, size_t length, uint64_t hash) {
+
+	size_t mask = g->actorSlotsCapacity - 1;
+	size_t slot = hash & mask;
+
+	while (g->actorSlots[slot] != EMPTY_SLOT) {
+		struct nameRef name = g->actorNames[g->actorSlots[slot]];
+		if (name.length == length && memcmp(g->nameBase + name.offset, actor, length) == 0) {
+			return slot;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+
+
+/*
+* growActorIndex(g) -- doubles the actor hash table and reinserts every actor ID.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: actorNames holds numActors valid names.
+* Side effects: reallocates actorSlots and updates actorSlotsCapacity.
+*/
+void growActorIndex(struct bacon_graph *g) {
+
+	size_t capacity = g->actorSlotsCapacity == 0 ? 1024 : g->actorSlotsCapacity * 2;
+	uint32_t *slots = malloc(capacity * sizeof(uint32_t));
+
+	if (slots == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	for (size_t index = 0; index < capacity; index++) {
+		slots[index] = EMPTY_SLOT;
+	}
+
+	free(g->actorSlots);
+	g->actorSlots = slots;
+	g->actorSlotsCapacity = capacity;
+
+	// Names are unique, so reinsertion only needs the first empty slot
+	for (uint32_t id = 0; id < g->numActors; id++) {
+		size_t slot = hashName(g->nameBase + g->actorNames[id].offset, g->actorNames[id].length) & (capacity - 1);
+		while (g->actorSlots[slot] != EMPTY_SLOT) {
+			slot = (slot + 1) & (capacity - 1);
+		}
+		g->actorSlots[slot] = id;
+	}
+}
+
+
+
+/*
+* findActor(g, actor, length) -- looks up an actor by name in the actor hash table.
+* g: pointer to the graph.
+* actor: pointer to the first byte of the actor's name.
+* length: length of the name in bytes.
+* Returns: the actor's ID if found, otherwise NO_ACTOR.
+* Assumptions: actor points to at least length readable bytes.
+* Side effects: none.
+*/
+uint32_t findActor(const struct bacon_graph *g, const char *actor, size_t length) {
+
+	if (g->actorSlots == NULL) {
+		return NO_ACTOR;
+	}
+	return g->actorSlots[probeActor(g, actor, length, hashName(actor, length))];
+}
+
+
+
+/*
+* foldName(name, length, out) -- normalizes a name for case- and spacing-insensitive lookups.
+* name: pointer to the first byte of the name.
+* length: length of the name in bytes.
+* out: buffer of at least length bytes to receive the folded name.
+* Returns: the length of the folded name.
+* Assumptions: none.
+* Side effects: writes to out.
+*
+* ASCII letters are lowercased, leading and trailing whitespace is dropped and every
+* run of whitespace inside the name becomes one space; other bytes (including
+* UTF-8 sequences) are kept as they are.
+*/
+size_t foldName(const char *name, size_t length, char *out) {
+
+	size_t folded = 0;
+	int pendingSpace = 0;
+
+	for (size_t index = 0; index < length; index++) {
+		unsigned char c = name[index];
+
+		if (isspace(c)) {
+			pendingSpace = folded > 0;
+			continue;
+		}
+		if (pendingSpace) {
+			out[folded++] = ' ';
+			pendingSpace = 0;
+		}
+		out[folded++] = tolower(c);
+	}
+	return folded;
+}
+
+
+
+/*
+* matchesFolded(g, actor, folded, length) -- checks whether an actor's name folds to a given name.
+* g: pointer to the graph.
+* actor: ID of the actor.
+* folded: pointer to a name already passed through foldName.
+* length: length of folded in bytes.
+* Returns: 1 if foldName of the actor's name equals folded, 0 otherwise.
+* Assumptions: none.
+* Side effects: none; the actor's name is folded on the fly, without a copy.
+*/
+int matchesFolded(const struct bacon_graph *g, uint32_t actor, const char *folded, size_t length) {
+
+	const char *name = g->nameBase + g->actorNames[actor].offset;
+	size_t nameLength = g->actorNames[actor].length;
+	size_t matched = 0;
+	int pendingSpace = 0;
+
+	for (size_t index = 0; index < nameLength; index++) {
+		unsigned char c = name[index];
+
+		if (isspace(c)) {
+			pendingSpace = matched > 0;
+			continue;
+		}
+		if (pendingSpace) {
+			if (matched == length || folded[matched] != ' ') {
+				return 0;
+			}
+			matched++;
+			pendingSpace = 0;
+		}
+		if (matched == length || folded[matched] != tolower(c)) {
+			return 0;
+		}
+		matched++;
+	}
+	return matched == length;
+}
+
+
+
+/*
+* indexFoldedNames(g) -- builds the hash table of actor IDs keyed by folded name.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: the actor names are final; called through lookupActor, which makes sure
+*              it runs once.
+* Side effects: allocates foldSlots. When several actors fold to the same name, the
+*               one with the lowest ID is kept.
+*/
+void indexFoldedNames(struct bacon_graph *g) {
+
+	size_t capacity = 1024;
+	while (capacity < (size_t) g->csr.numActors * 2) {
+		capacity *= 2;
+	}
+
+	g->foldSlots = malloc(capacity * sizeof(uint32_t));
+	char *buffer = NULL;
+	size_t bufferCapacity = 0;
+
+	if (g->foldSlots == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	for (size_t index = 0; index < capacity; index++) {
+		g->foldSlots[index] = EMPTY_SLOT;
+	}
+	g->foldSlotsCapacity = capacity;
+
+	for (uint32_t id = 0; id < g->csr.numActors; id++) {
+		struct nameRef name = g->actorNames[id];
+
+		if (name.length > bufferCapacity) {
+			bufferCapacity = name.length * 2;
+			free(buffer);
+			buffer = malloc(bufferCapacity);
+
+			if (buffer == NULL) {
+				fprintf(stderr, "Not Enough Memory.\n");
+				exit(1);
+			}
+		}
+
+		size_t length = foldName(g->nameBase + name.offset, name.length, buffer);
+		size_t slot = hashName(buffer, length) & (capacity - 1);
+
+		while (g->foldSlots[slot] != EMPTY_SLOT && !matchesFolded(g, g->foldSlots[slot], buffer, length)) {
+			slot = (slot + 1) & (capacity - 1);
+		}
+		if (g->foldSlots[slot] == EMPTY_SLOT) {
+			g->foldSlots[slot] = id;
+		}
+	}
+	free(buffer);
+}
+
+
+
+/*
+* lookupActor(g, actor, length) -- finds an actor by exact name, or else ignoring case
+*                                  and spacing.
+* g: pointer to the graph.
+* actor: pointer to the first byte of the name as typed.
+* length: length of the name in bytes.
+* Returns: the actor's ID if found, otherwise NO_ACTOR.
+* Assumptions: actor points to at least length readable bytes.
+* Side effects: temporarily allocates the folded name when the exact lookup fails. The
+*               first such miss on the graph builds its folded-name table, so opening
+*               a graph pays nothing for lookups that never miss.
+*/
+uint32_t lookupActor(const struct bacon_graph *g, const char *actor, size_t length) {
+
+	uint32_t id = findActor(g, actor, length);
+
+	if (id != NO_ACTOR) {
+		return id;
+	}
+
+	// The table is only a cache of the names, so building it leaves the graph logically const
+	if (!__atomic_load_n(&g->foldReady, __ATOMIC_ACQUIRE)) {
+		struct bacon_graph *shared = (struct bacon_graph *) g;
+
+		pthread_mutex_lock(&shared->foldLock);
+		if (!shared->foldReady) {
+			indexFoldedNames(shared);
+			__atomic_store_n(&shared->foldReady, 1, __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&shared->foldLock);
+	}
+
+	char *folded = malloc(length + 1);
+
+	if (folded == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	size_t foldedLength = foldName(actor, length, folded);
+	size_t mask = g->foldSlotsCapacity - 1;
+	size_t slot = hashName(folded, foldedLength) & mask;
+
+	while (g->foldSlots[slot] != EMPTY_SLOT && !matchesFolded(g, g->foldSlots[slot], folded, foldedLength)) {
+		slot = (slot + 1) & mask;
+	}
+	free(folded);
+	return g->foldSlots[slot];
+}
+
+
+
+/*
+* internActor(g, line, end, hash) -- returns the ID for an actor name, registering it on
+*                             first sight.
+* g: pointer to the graph.
+* line: pointer to the first byte of the actor's name inside nameBase.
+* end: pointer one past the last byte of the name.
+* hash: hashName of the name, computed by the parse worker that found it.
+* Returns: the existing or newly assigned actor ID.
+* Assumptions: line and end delimit a name inside the loaded input text.
+* Side effects: may append a view of the name to actorNames, assign it the next
+*               actor ID and grow actorNames and the hash table.
+*/
+uint32_t internActor(struct bacon_graph *g, const char *line, const char *end, uint64_t hash) {
+
+	size_t length = end - line;
+
+	// Keep the load factor at or below one half
+	if ((size_t) (g->numActors + 1) * 2 > g->actorSlotsCapacity) {
+		growActorIndex(g);
+	}
+
+	size_t slot = probeActor(g, line, length, hash);
+
+	if (g->actorSlots[slot] != EMPTY_SLOT) {
+		return g->actorSlots[slot];
+	}
+
+	if (g->numActors == g->actorsCapacity) {
+		g->actorsCapacity = g->actorsCapacity == 0 ? 1024 : g->actorsCapacity * 2;
+		g->actorNames = realloc(g->actorNames, g->actorsCapacity * sizeof(struct nameRef));
+
+		if (g->actorNames == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+	}
+
+	g->actorNames[g->numActors].offset = line - g->nameBase;
+	g->actorNames[g->numActors].length = (uint32_t) length;
+	g->actorSlots[slot] = g->numActors;
+	return g->numActors++;
+}
+
+	
+
+/*
+* createMovie(g, title, end) -- registers a movie and assigns it the next movie ID.
+* g: pointer to the graph.
+* title: pointer to the first byte of the movie's title inside nameBase.
+* end: pointer one past the last byte of the title.
+* Returns: the new movie ID.
+* Assumptions: title and end delimit a title inside the loaded input text.
+* Side effects: appends a view of the title to movieNames, growing it as needed.
+*/
+uint32_t createMovie(struct bacon_graph *g, const char *title, const char *end) {
+
+	if (g->numMovies == g->moviesCapacity) {
+		g->moviesCapacity = g->moviesCapacity == 0 ? 1024 : g->moviesCapacity * 2;
+		g->movieNames = realloc(g->movieNames, g->moviesCapacity * sizeof(struct nameRef));
+
+		if (g->movieNames == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+	}
+
+	g->movieNames[g->numMovies].offset = title - g->nameBase;
+	g->movieNames[g->numMovies].length = (uint32_t) (end - title);
+	return g->numMovies++;
+}
+
+
+
+/*
+* loadInput(g, path) -- makes the contents of the movies file available in memory.
+* g: pointer to an empty graph being loaded.
+* path: pointer to a string containing the file's path.
+* Returns: 0 on success, -1 if the file could not be opened or read.
+* Assumptions: path is a valid, null-terminated string.
+* Side effects: sets nameBase and nameBaseSize. Regular files are mmap'd read-only
+*               so parsing works in place; anything else (pipes, empty files) is
+*               read into a malloc'd buffer.
+*/
+int loadInput(struct bacon_graph *g, const char *path) {
+
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+		void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (map != MAP_FAILED) {
+			madvise(map, info.st_size, MADV_SEQUENTIAL);
+			g->nameBase = map;
+			g->nameBaseSize = info.st_size;
+			g->nameBaseMapped = 1;
+			close(fd);
+			return 0;
+		}
+	}
+
+	size_t capacity = 65536;
+	size_t size = 0;
+	char *buffer = malloc(capacity);
+	ssize_t got;
+
+	while (buffer != NULL && (got = read(fd, buffer + size, capacity - size)) > 0) {
+		size += got;
+		if (size == capacity) {
+			capacity *= 2;
+			char *grown = realloc(buffer, capacity);
+			if (grown == NULL) {
+				free(buffer);
+			}
+			buffer = grown;
+		}
+	}
+	close(fd);
+
+	if (buffer == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	if (got < 0) {
+		free(buffer);
+		return -1;
+	}
+
+	g->nameBase = buffer;
+	g->nameBaseSize = size;
+	g->nameBaseMapped = 0;
+	return 0;
+}
+
+
+
+/*
+* freeInput(g) -- releases the input text loaded by loadInput.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: no nameRef is used afterwards.
+* Side effects: unmaps or frees nameBase, unless it belonged to a snapshot that
+*               freeGraph already released.
+*/
+void freeInput(struct bacon_graph *g) {
+	if (g->nameBase == NULL) {
+		return;
+	} else if (g->nameBaseMapped) {
+		munmap((void *) g->nameBase, g->nameBaseSize);
+	} else {
+		free((void *) g->nameBase);
+	}
+	g->nameBase = NULL;
+	g->nameBaseSize = 0;
+}
+
+
+
+/*
+* nextLine(line, limit) -- finds the start of the line after the one at line.
+* line: pointer into the input text.
+* limit: pointer one past the end of the input text.
+* Returns: pointer to the first byte of the next line, or limit if there is none.
+* Assumptions: line < limit.
+* Side effects: none.
+*/
+const char* nextLine(const char *line, const char *limit) {
+	const char *end = memchr(line, '\n', limit - line);
+	return end == NULL ? limit : end + 1;
+}
+
+
+
+/*
+* parseChunkWorker(arg) -- parses one chunk of the input into chunk-local movies and
+*                          cast lines, without touching any global table.
+* arg: pointer to the parseChunk to fill.
+* Returns: NULL.
+* Assumptions: the chunk's range lies inside the loaded input text.
+* Side effects: allocates and fills the chunk's movies and cast arrays.
+*/
+void* parseChunkWorker(void *arg) {
+
+	struct parseChunk *chunk = arg;
+	const char *cursor = chunk->begin;
+
+	while (cursor < chunk->end) {
+
+		const char *line = cursor;
+		const char *end = memchr(line, '\n', chunk->end - line);
+		chunk->numLines++;
+
+		// Last line may have no newline char
+		if (end == NULL) {
+			end = chunk->end;
+		}
+		cursor = end + 1;
+
+		// NEW LINE, GO TO NEXT ITERATION/LINE
+		if (line == end || isspace((unsigned char) line[0])) {
+			continue;
+		}
+
+		// If it contains a ':'
+		if (containsMovie(line, end)) {
+
+			if (chunk->numMovies == chunk->moviesCapacity) {
+				chunk->moviesCapacity = chunk->moviesCapacity == 0 ? 256 : chunk->moviesCapacity * 2;
+				chunk->movies = realloc(chunk->movies, chunk->moviesCapacity * sizeof(struct nameRef));
+
+				if (chunk->movies == NULL) {
+					fprintf(stderr, "Not Enough Memory.\n");
+					exit(1);
+				}
+			}
+
+			const char *title = findMovie(line, end);
+			chunk->movies[chunk->numMovies].offset = title - chunk->base;
+			chunk->movies[chunk->numMovies].length = (uint32_t) (end - title);
+			chunk->numMovies++;
+
+		} else if (chunk->numMovies > 0) {
+
+			if (chunk->numCast == chunk->castCapacity) {
+				chunk->castCapacity = chunk->castCapacity == 0 ? 1024 : chunk->castCapacity * 2;
+				chunk->cast = realloc(chunk->cast, chunk->castCapacity * sizeof(struct castEntry));
+
+				if (chunk->cast == NULL) {
+					fprintf(stderr, "Not Enough Memory.\n");
+					exit(1);
+				}
+			}
+
+			struct castEntry *entry = &chunk->cast[chunk->numCast++];
+			entry->name.offset = line - chunk->base;
+			entry->name.length = (uint32_t) (end - line);
+			entry->hash = hashName(line, end - line);
+			entry->movie = chunk->numMovies - 1;
+		}
+	}
+	return NULL;
+}
+
+
+
+/*
+* parseFile(g) -- scans the loaded input text for movie and actor information.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: loadInput has succeeded.
+* Side effects: registers every movie and actor as views into nameBase, without
+*               copying any names, records every appearance for buildGraph and
+*               counts the lines scanned in g->stats.
+*
+* The text is cut into one chunk per worker thread, each starting at a movie line,
+* so every chunk holds whole movies and parses independently. The chunks are then
+* merged in file order, which interns actors globally and assigns the same IDs a
+* sequential parse would.
+*/
+void parseFile(struct bacon_graph *g) {
+
+	const char *limit = g->nameBase + g->nameBaseSize;
+	long threads = g->threads > 0 ? g->threads : sysconf(_SC_NPROCESSORS_ONLN);
+
+	// Unless told otherwise, small inputs are not worth a thread per MiB
+	if (threads < 1) {
+		threads = 1;
+	}
+	if (g->threads == 0 && (size_t) threads > g->nameBaseSize / (1 << 20) + 1) {
+		threads = g->nameBaseSize / (1 << 20) + 1;
+	}
+
+	struct parseChunk *chunks = calloc(threads, sizeof(struct parseChunk));
+	pthread_t *workers = calloc(threads, sizeof(pthread_t));
+	int *started = calloc(threads, sizeof(int));
+
+	if (chunks == NULL || workers == NULL || started == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	// Move each cut forward to the next line that starts a movie
+	const char *begin = g->nameBase;
+	for (long index = 0; index < threads; index++) {
+		const char *end = limit;
+
+		if (index + 1 < threads) {
+			end = g->nameBase + g->nameBaseSize / threads * (index + 1);
+			if (end < begin) {
+				end = begin;
+			}
+			if (end > g->nameBase && end[-1] != '\n') {
+				end = nextLine(end, limit);
+			}
+			while (end < limit) {
+				const char *lineEnd = nextLine(end, limit);
+				if (!isspace((unsigned char) end[0]) && containsMovie(end, lineEnd)) {
+					break;
+				}
+				end = lineEnd;
+			}
+		}
+		chunks[index].base = g->nameBase;
+		chunks[index].begin = begin;
+		chunks[index].end = end;
+		begin = end;
+	}
+
+	// Chunk 0 runs on this thread; a worker that fails to start runs inline too
+	for (long index = 1; index < threads; index++) {
+		started[index] = pthread_create(&workers[index], NULL, parseChunkWorker, &chunks[index]) == 0;
+	}
+	parseChunkWorker(&chunks[0]);
+	for (long index = 1; index < threads; index++) {
+		if (started[index]) {
+			pthread_join(workers[index], NULL);
+		} else {
+			parseChunkWorker(&chunks[index]);
+		}
+	}
+
+	// Last movie recorded per actor, indexed by actor ID
+	uint32_t *lastMovie = NULL;
+	uint32_t lastMovieCapacity = 0;
+
+	for (long index = 0; index < threads; index++) {
+		struct parseChunk *chunk = &chunks[index];
+		uint32_t firstMovie = g->numMovies;
+
+		g->stats.lines += chunk->numLines;
+
+		for (uint32_t movie = 0; movie < chunk->numMovies; movie++) {
+			const char *title = g->nameBase + chunk->movies[movie].offset;
+			createMovie(g, title, title + chunk->movies[movie].length);
+		}
+
+		for (size_t entry = 0; entry < chunk->numCast; entry++) {
+			struct castEntry *cast = &chunk->cast[entry];
+			const char *line = g->nameBase + cast->name.offset;
+
+			// ADD NODE (single hash probe finds or creates it)
+			uint32_t actor = internActor(g, line, line + cast->name.length, cast->hash);
+
+			if (lastMovieCapacity < g->actorsCapacity) {
+				lastMovie = realloc(lastMovie, g->actorsCapacity * sizeof(uint32_t));
+
+				if (lastMovie == NULL) {
+					fprintf(stderr, "Not Enough Memory.\n");
+					exit(1);
+				}
+
+				for (uint32_t id = lastMovieCapacity; id < g->actorsCapacity; id++) {
+					lastMovie[id] = UINT32_MAX;
+				}
+				lastMovieCapacity = g->actorsCapacity;
+			}
+
+			addAppearance(g, actor, firstMovie + cast->movie, lastMovie);
+		}
+
+		free(chunk->movies);
+		free(chunk->cast);
+	}
+	free(lastMovie);
+	free(chunks);
+	free(workers);
+	free(started);
+}
+
+
+
+/*
+* initSearchState(g, state) -- allocates a search state sized for the current graph.
+* g: pointer to the graph.
+* state: pointer to the searchState to set up.
+* Returns: void.
+* Assumptions: the actor and movie counts of g are final.
+* Side effects: allocates the stamp, level and parent arrays and the queue buffer.
+*/
+void initSearchState(const struct bacon_graph *g, struct searchState *state) {
+
+	state->graph = g;
+	state->epoch = 0;
+	state->actorsTouched = 0;
+	state->moviesTouched = 0;
+	state->actorStamps = calloc((size_t) g->csr.numActors + 1, sizeof(uint32_t));
+	state->movieStamps = calloc((size_t) g->csr.numMovies + 1, sizeof(uint32_t));
+	state->movieParents = malloc(((size_t) g->csr.numMovies + 1) * sizeof(uint32_t));
+	state->levels = malloc(((size_t) g->csr.numActors + 1) * sizeof(int));
+	state->parents = malloc(((size_t) g->csr.numActors + 1) * sizeof(uint32_t));
+	state->parentMovies = malloc(((size_t) g->csr.numActors + 1) * sizeof(uint32_t));
+
+	if (state->actorStamps == NULL || state->movieStamps == NULL || state->movieParents == NULL
+			|| state->levels == NULL			|| state->parents == NULL || state->parentMovies == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	// Every actor is queued at most once per search, so this never grows
+	size_t queueCapacity = 1024;
+	while (queueCapacity < g->csr.numActors) {
+		queueCapacity *= 2;
+	}
+	state->queue.items = NULL;
+	state->queue.capacity = 0;
+	resetQueue(&state->queue);
+	growQueue(&state->queue, queueCapacity);
+}
+
+
+
+/*
+* freeSearchState(state) -- frees the arrays of a search state.
+* state: pointer to the searchState.
+* Returns: void.
+* Assumptions: state was set up by initSearchState.
+* Side effects: deallocates the stamp, level and parent arrays and the queue buffer.
+*/
+void freeSearchState(struct searchState *state) {
+	free(state->actorStamps);
+	free(state->movieStamps);
+	free(state->movieParents);
+	free(state->levels);
+	free(state->parents);
+	free(state->parentMovies);
+	freeQueue(&state->queue);
+}
+
+
+
+/*
+* buildGraph(g) -- finalizes the parsed appearances into the CSR graph.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: parseFile has run; every appearance refers to registered IDs.
+* Side effects: allocates the offset and target arrays of the CSR graph from the arena of g,
+*               and frees the appearances array.
+*/
+void buildGraph(struct bacon_graph *g) {
+
+	g->csr.numActors = g->numActors;
+	g->csr.numMovies = g->numMovies;
+	g->csr.numEdges = (uint32_t) g->numAppearances;
+
+	// Arena memory starts zeroed, which the degree counts below rely on
+	g->csr.actorOffsets = arenaAlloc(&g->arena, ((size_t) g->numActors + 1) * sizeof(uint32_t), sizeof(uint32_t));
+	g->csr.movieOffsets = arenaAlloc(&g->arena, ((size_t) g->numMovies + 1) * sizeof(uint32_t), sizeof(uint32_t));
+	g->csr.actorMovies = arenaAlloc(&g->arena, (g->numAppearances + 1) * sizeof(uint32_t), sizeof(uint32_t));
+	g->csr.movieActors = arenaAlloc(&g->arena, (g->numAppearances + 1) * sizeof(uint32_t), sizeof(uint32_t));
+
+	// Count degrees, shifted by one so the prefix sum yields start offsets
+	for (size_t index = 0; index < g->numAppearances; index++) {
+		g->csr.actorOffsets[g->appearances[index].actor + 1]++;
+		g->csr.movieOffsets[g->appearances[index].movie + 1]++;
+	}
+	for (uint32_t id = 0; id < g->numActors; id++) {
+		g->csr.actorOffsets[id + 1] += g->csr.actorOffsets[id];
+	}
+	for (uint32_t id = 0; id < g->numMovies; id++) {
+		g->csr.movieOffsets[id + 1] += g->csr.movieOffsets[id];
+	}
+
+	// Scatter using the start offsets as cursors, then shift them back into place
+	for (size_t index = 0; index < g->numAppearances; index++) {
+		struct appearance *edge = &g->appearances[index];
+		g->csr.actorMovies[g->csr.actorOffsets[edge->actor]++] = edge->movie;
+		g->csr.movieActors[g->csr.movieOffsets[edge->movie]++] = edge->actor;
+	}
+	for (uint32_t id = g->numActors; id > 0; id--) {
+		g->csr.actorOffsets[id] = g->csr.actorOffsets[id - 1];
+	}
+	g->csr.actorOffsets[0] = 0;
+	for (uint32_t id = g->numMovies; id > 0; id--) {
+		g->csr.movieOffsets[id] = g->csr.movieOffsets[id - 1];
+	}
+	g->csr.movieOffsets[0] = 0;
+
+	free(g->appearances);
+	g->appearances = NULL;
+	g->numAppearances = 0;
+	g->appearancesCapacity = 0;
+}
+
+
+
+/*
+* findComponent(parents, actor) -- finds the representative of an actor's set.
+* parents: union-find parent array indexed by actor ID.
+* actor: ID of the actor.
+* Returns: the ID of the set's root actor.
+* Assumptions: following parents from actor reaches a root (its own parent).
+* Side effects: halves the path it walks, pointing every other actor at its grandparent.
+*/
+uint32_t findComponent(uint32_t *parents, uint32_t actor) {
+
+	while (parents[actor] != actor) {
+		parents[actor] = parents[parents[actor]];
+		actor = parents[actor];
+	}
+	return actor;
+}
+
+
+
+/*
+* labelComponents(g) -- computes the connected component of every actor.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: buildGraph has run (snapshots store the labels).
+* Side effects: allocates and fills g->components.
+*
+* Union-find over each movie's cast (union by size, path halving) is one near-linear
+* pass over the edges, far cheaper than the searches it lets us skip: actors in
+* different components are unreachable without exhausting one side's component.
+*/
+void labelComponents(struct bacon_graph *g) {
+
+	g->components = malloc(((size_t) g->csr.numActors + 1) * sizeof(uint32_t));
+	uint32_t *sizes = malloc(((size_t) g->csr.numActors + 1) * sizeof(uint32_t));
+
+	if (g->components == NULL || sizes == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	for (uint32_t a = 0; a < g->csr.numActors; a++) {
+		g->components[a] = a;
+		sizes[a] = 1;
+	}
+
+	for (uint32_t movie = 0; movie < g->csr.numMovies; movie++) {
+		uint32_t first = g->csr.movieOffsets[movie];
+
+		for (uint32_t co = first + 1; co < g->csr.movieOffsets[movie + 1]; co++) {
+			uint32_t root = findComponent(g->components, g->csr.movieActors[first]);
+			uint32_t other = findComponent(g->components, g->csr.movieActors[co]);
+
+			if (root == other) {
+				continue;
+			}
+			if (sizes[root] < sizes[other]) {
+				uint32_t swap = root;
+				root = other;
+				other = swap;
+			}
+			g->components[other] = root;
+			sizes[root] += sizes[other];
+		}
+	}
+
+	// Flatten so every lookup is a single read
+	for (uint32_t a = 0; a < g->csr.numActors; a++) {
+		g->components[a] = findComponent(g->components, a);
+	}
+	free(sizes);
+}
+
+
+
+/*
+* freeGraph(g) -- frees the CSR graph and the name tables.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: buildGraph or loadSnapshot has run.
+* Side effects: unmaps the arena of g and deallocates the name tables, the actor hash
+*               table and the component labels, or unmaps the snapshot they point into.
+*/
+void freeGraph(struct bacon_graph *g) {
+	if (g->snapshotMap != NULL) {
+		munmap(g->snapshotMap, g->snapshotSize);
+		g->snapshotMap = NULL;
+		g->nameBase = NULL;
+	} else {
+		freeArena(&g->arena);
+		free(g->actorNames);
+		free(g->movieNames);
+		free(g->actorSlots);
+		free(g->components);
+	}
+	g->components = NULL;
+}
+
+
+
+/*
+* writeSection(out, header, section, data, size) -- appends one section to a snapshot.
+* out: pointer to the snapshot file being written.
+* header: pointer to the header receiving the section's offset.
+* section: which section is being written.
+* data: pointer to the section's bytes.
+* size: number of bytes to write.
+* Returns: 0 on success, -1 on a write error.
+* Assumptions: out is open for writing and positioned at the end of the file.
+* Side effects: pads the file to 8-byte alignment, then writes the data.
+*/
+int writeSection(FILE *out, struct snapshotHeader *header, enum snapshotSection section,
+		const void *data, size_t size) {
+
+	static const char padding[8] = { 0 };
+	long position = ftell(out);
+
+	if (position < 0) {
+		return -1;
+	}
+
+	size_t pad = (8 - position % 8) % 8;
+
+	if (fwrite(padding, 1, pad, out) != pad) {
+		return -1;
+	}
+	header->sections[section] = (uint64_t) position + pad;
+
+	if (size > 0 && fwrite(data, 1, size, out) != size) {
+		return -1;
+	}
+	return 0;
+}
+
+
+
+/*
+* saveSnapshot(g, path, center, distances, parents, parentMovies) -- writes the graph,
+*                             its names and one center's table to a binary snapshot file.
+* g: pointer to the graph.
+* path: pointer to a string containing the snapshot's path.
+* center: actor ID of the center, or NO_ACTOR to store no table.
+* distances, parents, parentMovies: the center's BFSAll results, unused for NO_ACTOR.
+* Returns: 0 on success, -1 if the file could not be written.
+* Assumptions: the graph is built and its components are labeled.
+* Side effects: creates or overwrites the file; temporarily allocates compacted
+*               copies of the names so only name bytes, not the whole input, are stored.
+*/
+int saveSnapshot(const struct bacon_graph *g, const char *path, uint32_t center, const int *distances,
+		const uint32_t *parents, const uint32_t *parentMovies) {
+
+	FILE *out = fopen(path, "wb");
+
+	if (out == NULL) {
+		return -1;
+	}
+
+	struct snapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.flags = center != NO_ACTOR ? SNAPSHOT_HAS_BACON : 0;
+	header.numActors = g->csr.numActors;
+	header.numMovies = g->csr.numMovies;
+	header.numEdges = g->csr.numEdges;
+	header.bacon = center;
+	header.slotsCapacity = g->actorSlotsCapacity;
+
+	// Re-point every name at a packed copy of just the name bytes
+	size_t total = (size_t) g->csr.numActors + g->csr.numMovies;
+	struct nameRef *names = calloc(total + 1, sizeof(struct nameRef));
+	uint64_t namesSize = 0;
+
+	if (names == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	for (size_t index = 0; index < total; index++) {
+		struct nameRef name = index < g->csr.numActors ? g->actorNames[index] : g->movieNames[index - g->csr.numActors];
+		names[index].offset = namesSize;
+		names[index].length = name.length;
+		namesSize += name.length;
+	}
+	header.namesSize = namesSize;
+
+	int failed = fwrite(&header, sizeof(header), 1, out) != 1;
+	long namesStart = ftell(out);
+
+	// Header size is a multiple of 8, so the name bytes follow it directly
+	header.sections[SECTION_NAMES] = (uint64_t) namesStart;
+	for (size_t index = 0; index < total && !failed; index++) {
+		struct nameRef name = index < g->csr.numActors ? g->actorNames[index] : g->movieNames[index - g->csr.numActors];
+		failed = fwrite(g->nameBase + name.offset, 1, name.length, out) != name.length;
+	}
+
+	failed = failed
+		|| writeSection(out, &header, SECTION_ACTOR_NAMES, names, (size_t) g->csr.numActors * sizeof(struct nameRef))
+		|| writeSection(out, &header, SECTION_MOVIE_NAMES, names + g->csr.numActors, (size_t) g->csr.numMovies * sizeof(struct nameRef))
+		|| writeSection(out, &header, SECTION_ACTOR_OFFSETS, g->csr.actorOffsets, ((size_t) g->csr.numActors + 1) * sizeof(uint32_t))
+		|| writeSection(out, &header, SECTION_ACTOR_MOVIES, g->csr.actorMovies, (size_t) g->csr.numEdges * sizeof(uint32_t))
+		|| writeSection(out, &header, SECTION_MOVIE_OFFSETS, g->csr.movieOffsets, ((size_t) g->csr.numMovies + 1) * sizeof(uint32_t))
+		|| writeSection(out, &header, SECTION_MOVIE_ACTORS, g->csr.movieActors, (size_t) g->csr.numEdges * sizeof(uint32_t))
+		|| writeSection(out, &header, SECTION_ACTOR_SLOTS, g->actorSlots, g->actorSlotsCapacity * sizeof(uint32_t))
+		|| writeSection(out, &header, SECTION_COMPONENTS, g->components, (size_t) g->csr.numActors * sizeof(uint32_t));
+
+	if (!failed && center != NO_ACTOR) {
+		failed = writeSection(out, &header, SECTION_BACON_DISTANCES, distances, (size_t) g->csr.numActors * sizeof(int))
+			|| writeSection(out, &header, SECTION_BACON_PARENTS, parents, (size_t) g->csr.numActors * sizeof(uint32_t))
+			|| writeSection(out, &header, SECTION_BACON_PARENT_MOVIES, parentMovies, (size_t) g->csr.numActors * sizeof(uint32_t));
+	}
+	free(names);
+
+	// Now that every offset is known, fill in the real header
+	failed = failed || fseek(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1;
+
+	if (fclose(out) != 0 || failed) {
+		return -1;
+	}
+	return 0;
+}
+
+
+
+/*
+* snapshotSection(g, header, section, size) -- locates a section of a mapped snapshot.
+* g: pointer to the graph.
+* header: pointer to the mapped snapshot header.
+* section: which section to locate.
+* size: number of bytes the section must hold.
+* Returns: pointer to the section inside snapshotMap, or NULL if it lies outside the file.
+* Assumptions: snapshotMap and snapshotSize describe the mapped file.
+* Side effects: none.
+*/
+void* snapshotSection(const struct bacon_graph *g, const struct snapshotHeader *header, enum snapshotSection section, uint64_t size) {
+
+	uint64_t offset = header->sections[section];
+
+	if (offset % 8 != 0 || offset > g->snapshotSize || size > g->snapshotSize - offset) {
+		return NULL;
+	}
+	return (char *) g->snapshotMap + offset;
+}
+
+
+
+/*
+* validOffsets(offsets, count, total) -- checks a CSR offset array read from a file.
+* offsets: array of count + 1 offsets.
+* count: number of groups.
+* total: number of entries the groups split.
+* Returns: 1 if the offsets start at 0, never decrease and end at total, 0 otherwise.
+* Assumptions: none.
+* Side effects: none.
+*/
+int validOffsets(const uint32_t *offsets, uint32_t count, uint32_t total) {
+
+	uint32_t decreases = 0;
+
+	for (uint32_t index = 0; index < count; index++) {
+		decreases |= offsets[index] > offsets[index + 1];
+	}
+	return offsets[0] == 0 && offsets[count] == total && !decreases;
+}
+
+
+
+/*
+* validIDs(ids, count, limit) -- checks that IDs read from a file are in range.
+* ids: array of count IDs.
+* count: number of IDs.
+* limit: number of valid IDs.
+* Returns: 1 if every ID is below limit, 0 otherwise.
+* Assumptions: none.
+* Side effects: none.
+*/
+int validIDs(const uint32_t *ids, size_t count, uint32_t limit) {
+
+	uint32_t largest = 0;
+
+	for (size_t index = 0; index < count; index++) {
+		largest = ids[index] > largest ? ids[index] : largest;
+	}
+	return count == 0 || largest < limit;
+}
+
+
+
+/*
+* validNames(names, count, size) -- checks that name refs read from a file lie in the text.
+* names: array of count name refs.
+* count: number of names.
+* size: size in bytes of the name text.
+* Returns: 1 if every name fits inside the text, 0 otherwise.
+* Assumptions: none.
+* Side effects: none.
+*/
+int validNames(const struct nameRef *names, uint32_t count, uint64_t size) {
+
+	for (uint32_t index = 0; index < count; index++) {
+		if (names[index].offset > size || names[index].length > size - names[index].offset) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+
+/*
+* validSnapshot(g) -- checks the contents of a freshly mapped snapshot.
+* g: pointer to the graph, with every table pointing into the snapshot.
+* Returns: 1 if the snapshot can be searched safely, 0 otherwise.
+* Assumptions: every section lies inside the file.
+* Side effects: reads every section, which pulls the graph into the page cache.
+*
+* A snapshot is trusted as much as a movies file, so a damaged or hand-edited one
+* must be turned away here rather than crash a search later: offsets must split the
+* edges in order, every stored ID must be in range, every name must lie in the text,
+* the hash table must keep an empty slot to end its probes, and the center table
+* must lead every reached actor back to the center one level at a time. Component
+* labels are only ever compared with each other, so any stored values are safe.
+*/
+int validSnapshot(const struct bacon_graph *g) {
+
+	const struct csrGraph *csr = &g->csr;
+
+	if (!validOffsets(csr->actorOffsets, csr->numActors, csr->numEdges)
+			|| !validOffsets(csr->movieOffsets, csr->numMovies, csr->numEdges)
+			|| !validIDs(csr->actorMovies, csr->numEdges, csr->numMovies)
+			|| !validIDs(csr->movieActors, csr->numEdges, csr->numActors)
+			|| !validNames(g->actorNames, csr->numActors, g->nameBaseSize)
+			|| !validNames(g->movieNames, csr->numMovies, g->nameBaseSize)) {
+		return 0;
+	}
+
+	size_t used = 0;
+
+	for (size_t slot = 0; slot < g->actorSlotsCapacity; slot++) {
+		if (g->actorSlots[slot] != EMPTY_SLOT) {
+			if (g->actorSlots[slot] >= csr->numActors) {
+				return 0;
+			}
+			used++;
+		}
+	}
+	if (g->actorSlotsCapacity > 0 && used >= g->actorSlotsCapacity) {
+		return 0;
+	}
+
+	if (g->snapshotCenter != NO_ACTOR) {
+		for (uint32_t a = 0; a < csr->numActors; a++) {
+			int distance = g->snapshotDistances[a];
+
+			if (distance == 0 ? a != g->snapshotCenter
+					: distance != -1 && (distance < 0 || g->snapshotParents[a] >= csr->numActors
+						|| g->snapshotParentMovies[a] >= csr->numMovies
+						|| g->snapshotDistances[g->snapshotParents[a]] != distance - 1)) {
+				return 0;
+			}
+		}
+		if (g->snapshotDistances[g->snapshotCenter] != 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+
+/*
+* loadSnapshot(g, path) -- maps a binary snapshot and points the graph tables into it.
+* g: pointer to an empty graph.
+* path: pointer to a string containing the snapshot's path.
+* Returns: 0 on success, -1 if the file is missing, truncated, damaged (see
+*          validSnapshot) or not a snapshot of this version.
+* Assumptions: nothing has been loaded into g yet.
+* Side effects: maps the file read-only into snapshotMap and sets nameBase, the name
+*               tables, csr, the actor hash table, the component labels and, when present, the snapshot's
+*               center table to views of it (snapshotCenter stays NO_ACTOR otherwise).
+*               Only pages that are later touched are read from disk.
+*/
+int loadSnapshot(struct bacon_graph *g, const char *path) {
+
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(struct snapshotHeader)) {
+		close(fd);
+		return -1;
+	}
+
+	g->snapshotMap = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (g->snapshotMap == MAP_FAILED) {
+		g->snapshotMap = NULL;
+		return -1;
+	}
+	g->snapshotSize = info.st_size;
+
+	const struct snapshotHeader *header = g->snapshotMap;
+	uint64_t actors = header->numActors;
+	uint64_t movies = header->numMovies;
+	uint64_t edges = header->numEdges;
+
+	if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION
+			|| (header->slotsCapacity == 0 && actors > 0) || (header->slotsCapacity & (header->slotsCapacity - 1)) != 0) {
+		munmap(g->snapshotMap, g->snapshotSize);
+		g->snapshotMap = NULL;
+		return -1;
+	}
+
+	// The name text is the only section that is not 8-byte aligned in size
+	if (header->sections[SECTION_NAMES] > g->snapshotSize || header->namesSize > g->snapshotSize - header->sections[SECTION_NAMES]) {
+		munmap(g->snapshotMap, g->snapshotSize);
+		g->snapshotMap = NULL;
+		return -1;
+	}
+	g->nameBase = (const char *) g->snapshotMap + header->sections[SECTION_NAMES];
+	g->nameBaseSize = header->namesSize;
+
+	g->actorNames = snapshotSection(g, header, SECTION_ACTOR_NAMES, actors * sizeof(struct nameRef));
+	g->movieNames = snapshotSection(g, header, SECTION_MOVIE_NAMES, movies * sizeof(struct nameRef));
+	g->csr.actorOffsets = snapshotSection(g, header, SECTION_ACTOR_OFFSETS, (actors + 1) * sizeof(uint32_t));
+	g->csr.actorMovies = snapshotSection(g, header, SECTION_ACTOR_MOVIES, edges * sizeof(uint32_t));
+	g->csr.movieOffsets = snapshotSection(g, header, SECTION_MOVIE_OFFSETS, (movies + 1) * sizeof(uint32_t));
+	g->csr.movieActors = snapshotSection(g, header, SECTION_MOVIE_ACTORS, edges * sizeof(uint32_t));
+	g->actorSlots = snapshotSection(g, header, SECTION_ACTOR_SLOTS, header->slotsCapacity * sizeof(uint32_t));
+	g->components = snapshotSection(g, header, SECTION_COMPONENTS, actors * sizeof(uint32_t));
+
+	g->snapshotCenter = NO_ACTOR;
+	if ((header->flags & SNAPSHOT_HAS_BACON) && header->bacon < actors) {
+		g->snapshotDistances = snapshotSection(g, header, SECTION_BACON_DISTANCES, actors * sizeof(int));
+		g->snapshotParents = snapshotSection(g, header, SECTION_BACON_PARENTS, actors * sizeof(uint32_t));
+		g->snapshotParentMovies = snapshotSection(g, header, SECTION_BACON_PARENT_MOVIES, actors * sizeof(uint32_t));
+
+		if (g->snapshotDistances != NULL && g->snapshotParents != NULL && g->snapshotParentMovies != NULL) {
+			g->snapshotCenter = header->bacon;
+		}
+	}
+
+	g->numActors = g->csr.numActors = header->numActors;
+	g->numMovies = g->csr.numMovies = header->numMovies;
+	g->csr.numEdges = header->numEdges;
+	g->actorSlotsCapacity = header->slotsCapacity;
+
+	// A graph without actors never allocated its hash table, and findActor expects NULL then
+	if (g->actorSlotsCapacity == 0) {
+		g->actorSlots = NULL;
+	}
+
+	if (g->actorNames == NULL || g->movieNames == NULL || g->csr.actorOffsets == NULL || g->csr.actorMovies == NULL
+			|| g->csr.movieOffsets == NULL || g->csr.movieActors == NULL || g->components == NULL
+			|| (g->actorSlots == NULL && g->actorSlotsCapacity > 0) || !validSnapshot(g)) {
+		munmap(g->snapshotMap, g->snapshotSize);
+		g->snapshotMap = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+
+
+/*
+* printActorsWithMovies(g) -- prints a list of all movies and their associated actors.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: buildGraph has run.
+* Side effects: outputs movie names and their actor lists to standard output.
+* Note: This function is primarily used for debugging and verifying movie-actor relationships.
+*/
+void printActorsWithMovies(const struct bacon_graph *g) {
+
+    for (uint32_t movie = 0; movie < g->csr.numMovies; movie++) {
+
+	    printf("MOVIE: ");
+	    printName(g, stdout, g->movieNames[movie]);
+	    printf("\n");
+
+	    for (uint32_t edge = g->csr.movieOffsets[movie]; edge < g->csr.movieOffsets[movie + 1]; edge++) {
+		    printf("	ACTOR: ");
+		    printName(g, stdout, g->actorNames[g->csr.movieActors[edge]]);
+		    printf("\n");
+	    }
+    }
+}
+
+
+
+/*
+* beginSearch(state) -- starts a new search generation, invalidating every visited mark.
+* state: pointer to the searchState to reuse.
+* Returns: the epoch that marks actors and movies visited by the new search.
+* Assumptions: state was set up by initSearchState.
+* Side effects: increments state->epoch and empties its queue; clears both stamp
+*               arrays only when the counter wraps around.
+*/
+uint32_t beginSearch(struct searchState *state) {
+
+	const struct bacon_graph *g = state->graph;
+
+	state->epoch++;
+
+	if (state->epoch == 0) {
+		memset(state->actorStamps, 0, (size_t) g->csr.numActors * sizeof(uint32_t));
+		memset(state->movieStamps, 0, (size_t) g->csr.numMovies * sizeof(uint32_t));
+		state->epoch = 1;
+	}
+	resetQueue(&state->queue);
+	return state->epoch;
+}
+
+
+
+/*
+* visitActor(state, actor, parent, movie) -- marks an actor as reached by a search.
+* state: pointer to the searchState of the search.
+* actor: ID of the newly reached actor.
+* parent: ID of the actor it was reached through.
+* movie: ID of the movie the two share.
+* Returns: void.
+* Assumptions: actor is not yet stamped in the current epoch; parent is.
+* Side effects: stamps and counts actor, sets its level and parents and enqueues it.
+*/
+void visitActor(struct searchState *state, uint32_t actor, uint32_t parent, uint32_t movie) {
+	state->actorStamps[actor] = state->epoch;
+	state->actorsTouched++;
+	state->levels[actor] = state->levels[parent] + 1;
+	state->parents[actor] = parent;
+	state->parentMovies[actor] = movie;
+	enqueue(&state->queue, actor);
+}
+
+
+
+/*
+* expandLevel(side, other, best, meet) -- expands every actor on one side's current
+*                             BFS level, checking new actors against the other side.
+* side: pointer to the searchState whose frontier is expanded.
+* other: pointer to the searchState of the opposite direction.
+* best: pointer to the shortest connection found so far (-1 for none).
+* meet: pointer to the actor on that shortest connection where the sides meet.
+* Returns: void.
+* Assumptions: both searches have begun and neither queue is empty.
+* Side effects: dequeues the current level of side, stamps and enqueues the next
+*               one, and lowers *best and updates *meet when a shorter meeting is found.
+*/
+void expandLevel(struct searchState *side, struct searchState *other, int *best, uint32_t *meet) {
+
+	const struct bacon_graph *g = side->graph;
+	size_t width = side->queue.count;
+
+	for (size_t index = 0; index < width; index++) {
+		uint32_t a = dequeue(&side->queue);
+
+		for (uint32_t ml = g->csr.actorOffsets[a]; ml < g->csr.actorOffsets[a + 1]; ml++) {
+			uint32_t movie = g->csr.actorMovies[ml];
+
+			// Its cast was already queued by an earlier (no farther) actor
+			if (side->movieStamps[movie] == side->epoch) {
+				continue;
+			}
+			side->movieStamps[movie] = side->epoch;
+			side->moviesTouched++;
+
+			for (uint32_t co = g->csr.movieOffsets[movie]; co < g->csr.movieOffsets[movie + 1]; co++) {
+				uint32_t c = g->csr.movieActors[co];
+
+				if (side->actorStamps[c] == side->epoch) {
+					continue;
+				}
+				visitActor(side, c, a, movie);
+
+				if (other->actorStamps[c] == other->epoch) {
+					int length = side->levels[c] + other->levels[c];
+					if (*best == -1 || length < *best) {
+						*best = length;
+						*meet = c;
+					}
+				}
+			}
+		}
+	}
+}
+
+
+
+/*
+* BFS(forward, backward, start, target, meet) -- performs a bidirectional
+*                        Breadth-First Search to find the shortest path (in terms
+*                        of degrees of separation) between two actors.
+* forward: pointer to the searchState to root at start.
+* backward: pointer to the searchState to root at target.
+* start: ID of the starting actor.
+* target: ID of the target actor.
+* meet: pointer to receive the actor where the two searches met on a shortest path.
+* Returns: the shortest path length (number of connections) or -1 if no path exists.
+* Assumptions: buildGraph has run and both IDs are valid.
+* Side effects: starts new epochs in forward and backward and fills their levels
+*               and parents.
+*
+* Both searches advance one whole level at a time, always on the side with the
+* smaller frontier. A meeting is only final once its level is finished, since
+* another actor on the same level may close a shorter connection.
+*/
+int BFS(struct searchState *forward, struct searchState *backward, uint32_t start, uint32_t target,
+		uint32_t *meet) {
+
+	beginSearch(forward);
+	beginSearch(backward);
+
+	forward->actorStamps[start] = forward->epoch;
+	forward->levels[start] = 0;
+	enqueue(&forward->queue, start);
+
+	backward->actorStamps[target] = backward->epoch;
+	backward->levels[target] = 0;
+	enqueue(&backward->queue, target);
+
+	*meet = start;
+	if (start == target) {
+		return 0;
+	}
+
+	int best = -1;
+
+	while (forward->queue.count > 0 && backward->queue.count > 0) {
+
+		if (forward->queue.count <= backward->queue.count) {
+			expandLevel(forward, backward, &best, meet);
+		} else {
+			expandLevel(backward, forward, &best, meet);
+		}
+
+		if (best != -1) {
+			return best;
+		}
+	}
+	return -1; // Not found
+}
+
+
+
+
+// Beamer's switching thresholds for BFSAll: go bottom-up once the frontier's edges
+// exceed 1/BOTTOM_UP_ALPHA of the unvisited ones, and back once it holds fewer
+// than 1/TOP_DOWN_BETA of all actors
+#define BOTTOM_UP_ALPHA 14
+#define TOP_DOWN_BETA 24
+
+
+
+// Steps of a parallel full BFS level; a bottom-up level takes two
+enum bfsPhase {
+	PHASE_TOP_DOWN,  // frontier actors claim their movies and unvisited cast mates
+	PHASE_MOVIES,    // bottom-up: unreached movies look for a frontier actor in their cast
+	PHASE_ACTORS,    // bottom-up: unvisited actors look for a movie reached this level
+	PHASE_DONE,
+	PHASE_EXIT       // the graph is being closed and the pool's threads return
+};
+
+// Entries (frontier actors, movies or actors) a thread claims at a time
+#define BFS_BLOCK 256
+
+// Fewest actors per thread before BFSAll uses another one (without --threads)
+#define BFS_ACTORS_PER_THREAD (1 << 16)
+
+struct bfsJob;
+
+/*
+ * bfsWorker -- One thread of a parallel full BFS.
+ *
+ * Fields:
+ *   job           - The shared bfsJob.
+ *   found         - Actors this thread reached during the current level.
+ *   numFound      - Number of entries in found.
+ *   foundCapacity - Allocated entries in found.
+ *   foundEdges    - Total movie count of the actors in found.
+ */
+struct bfsWorker {
+	struct bfsJob *job;
+	uint32_t *found;
+	size_t numFound;
+	size_t foundCapacity;
+	uint64_t foundEdges;
+};
+
+/*
+ * bfsJob -- State shared by the threads of a parallel full BFS.
+ *
+ * Fields:
+ *   graph                            - The graph searched.
+ *   distances, parents, parentMovies - BFSAll's output arrays.
+ *   movieStamps, movieParents        - Per-movie marks of the search state.
+ *   epoch                            - Stamp of the search.
+ *   order          - Every reached actor in level order; frontier is [levelStart, levelEnd).
+ *   levelStart     - First entry of order on the frontier.
+ *   levelEnd       - End of the frontier and of order.
+ *   level          - Distance of the frontier actors.
+ *   phase          - Step all threads run next.
+ *   frontierEdges  - Total movie count of the frontier actors.
+ *   unvisitedEdges - Total movie count of the actors not reached yet.
+ *   bottomUp       - Nonzero while levels are expanded bottom-up.
+ *   cursor         - Next block of the current step to claim.
+ *   gate           - Held until the barrier is set up for the threads that started.
+ *   barrier        - Separates the steps, and the searches from each other.
+ *   workers        - One bfsWorker per thread; entry 0 is the coordinating thread.
+ *   threads        - Number of entries in workers.
+ */
+struct bfsJob {
+	const struct bacon_graph *graph;
+	int *distances;
+	uint32_t *parents;
+	uint32_t *parentMovies;
+	uint32_t *movieStamps;
+	uint32_t *movieParents;
+	uint32_t epoch;
+	uint32_t *order;
+	size_t levelStart;
+	size_t levelEnd;
+	int level;
+	enum bfsPhase phase;
+	uint64_t frontierEdges;
+	uint64_t unvisitedEdges;
+	int bottomUp;
+	atomic_size_t cursor;
+	pthread_mutex_t gate;
+	pthread_barrier_t barrier;
+	struct bfsWorker *workers;
+	long threads;
+};
+
+/*
+ * bfsPool -- Threads kept alive between the full searches on one graph.
+ *
+ * Fields:
+ *   job     - The job the threads work on; BFSAll fills in each search.
+ *   handles - Handles of the threads running workers 1 .. job.threads - 1.
+ */
+struct bfsPool {
+	struct bfsJob job;
+	pthread_t *handles;
+};
+
+
+
+/*
+* bfsFound(worker, actor, parent, movie) -- records an actor reached by a thread.
+* worker: pointer to the bfsWorker that reached it.
+* actor: ID of the reached actor.
+* parent: ID of the actor it was reached through.
+* movie: ID of the movie the two share.
+* Returns: void.
+* Assumptions: this thread alone owns actor's distance (it won the claim).
+* Side effects: writes its parent entries and appends it to the worker's found list,
+*               growing the list if needed.
+*/
+void bfsFound(struct bfsWorker *worker, uint32_t actor, uint32_t parent, uint32_t movie) {
+
+	struct bfsJob *job = worker->job;
+	const struct bacon_graph *g = job->graph;
+
+	job->parents[actor] = parent;
+	job->parentMovies[actor] = movie;
+
+	if (worker->numFound == worker->foundCapacity) {
+		worker->foundCapacity = worker->foundCapacity == 0 ? 1024 : worker->foundCapacity * 2;
+		worker->found = realloc(worker->found, worker->foundCapacity * sizeof(uint32_t));
+
+		if (worker->found == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+	}
+	worker->found[worker->numFound++] = actor;
+	worker->foundEdges += g->csr.actorOffsets[actor + 1] - g->csr.actorOffsets[actor];
+}
+
+
+
+/*
+* bfsStep(worker) -- runs this thread's share of the current step of a parallel BFS.
+* worker: pointer to the thread's bfsWorker.
+* Returns: void.
+* Assumptions: every thread runs the same step between two barrier waits.
+* Side effects: claims blocks of the step until none are left, marking the movies
+*               and actors they reach.
+*
+* Top-down, several threads may reach the same movie or actor, so each claims it
+* with a compare-and-swap and only the winner expands or records it. Bottom-up,
+* every movie or actor is looked at by exactly one thread, so plain writes do.
+*/
+void bfsStep(struct bfsWorker *worker) {
+
+	struct bfsJob *job = worker->job;
+	const struct bacon_graph *g = job->graph;
+	int level = job->level;
+	uint32_t epoch = job->epoch;
+	size_t total;
+
+	switch (job->phase) {
+	case PHASE_TOP_DOWN:
+		total = job->levelEnd - job->levelStart;
+		break;
+	case PHASE_MOVIES:
+		total = g->csr.numMovies;
+		break;
+	case PHASE_ACTORS:
+		total = g->csr.numActors;
+		break;
+	default:
+		return;
+	}
+
+	size_t first;
+	while ((first = atomic_fetch_add(&job->cursor, BFS_BLOCK)) < total) {
+		size_t last = first + BFS_BLOCK < total ? first + BFS_BLOCK : total;
+
+		for (size_t index = first; index < last; index++) {
+
+			if (job->phase == PHASE_TOP_DOWN) {
+				uint32_t a = job->order[job->levelStart + index];
+
+				for (uint32_t ml = g->csr.actorOffsets[a]; ml < g->csr.actorOffsets[a + 1]; ml++) {
+					uint32_t movie = g->csr.actorMovies[ml];
+					uint32_t stamp = __atomic_load_n(&job->movieStamps[movie], __ATOMIC_RELAXED);
+
+					if (stamp == epoch || !__atomic_compare_exchange_n(&job->movieStamps[movie],
+							&stamp, epoch, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+						continue;
+					}
+					job->movieParents[movie] = a;
+
+					for (uint32_t co = g->csr.movieOffsets[movie]; co < g->csr.movieOffsets[movie + 1]; co++) {
+						uint32_t c = g->csr.movieActors[co];
+						int unvisited = -1;
+
+						if (__atomic_load_n(&job->distances[c], __ATOMIC_RELAXED) == -1
+								&& __atomic_compare_exchange_n(&job->distances[c], &unvisited,
+									level + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+							bfsFound(worker, c, a, movie);
+						}
+					}
+				}
+			} else if (job->phase == PHASE_MOVIES) {
+				uint32_t movie = (uint32_t) index;
+
+				if (job->movieStamps[movie] == epoch) {
+					continue;
+				}
+				for (uint32_t co = g->csr.movieOffsets[movie]; co < g->csr.movieOffsets[movie + 1]; co++) {
+					uint32_t c = g->csr.movieActors[co];
+
+					if (job->distances[c] == level) {
+						job->movieStamps[movie] = epoch;
+						job->movieParents[movie] = c;
+						break;
+					}
+				}
+			} else {
+				uint32_t c = (uint32_t) index;
+
+				if (job->distances[c] != -1) {
+					continue;
+				}
+
+				// Any reached movie of an unvisited actor was reached this level,
+				// since earlier ones already had their whole cast visited
+				for (uint32_t ml = g->csr.actorOffsets[c]; ml < g->csr.actorOffsets[c + 1]; ml++) {
+					uint32_t movie = g->csr.actorMovies[ml];
+
+					if (job->movieStamps[movie] == epoch) {
+						job->distances[c] = level + 1;
+						bfsFound(worker, c, job->movieParents[movie], movie);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+
+
+/*
+* bfsAdvance(job) -- sets up the next step of a parallel BFS once all threads are done.
+* job: pointer to the shared bfsJob.
+* Returns: void.
+* Assumptions: called by one thread while the others wait at the barrier.
+* Side effects: after a finished level, appends every thread's found actors to the
+*               order as the new frontier and picks the direction of the next level
+*               (PHASE_DONE when the frontier is empty); resets the claim cursor.
+*/
+void bfsAdvance(struct bfsJob *job) {
+
+	const struct bacon_graph *g = job->graph;
+
+	if (job->phase == PHASE_MOVIES) {
+		job->phase = PHASE_ACTORS;
+		atomic_store(&job->cursor, 0);
+		return;
+	}
+
+	job->levelStart = job->levelEnd;
+	job->frontierEdges = 0;
+	for (long index = 0; index < job->threads; index++) {
+		struct bfsWorker *worker = &job->workers[index];
+
+		if (worker->numFound > 0) {
+			memcpy(&job->order[job->levelEnd], worker->found, worker->numFound * sizeof(uint32_t));
+		}
+		job->levelEnd += worker->numFound;
+		job->frontierEdges += worker->foundEdges;
+		worker->numFound = 0;
+		worker->foundEdges = 0;
+	}
+	job->unvisitedEdges -= job->frontierEdges;
+	job->level++;
+
+	size_t frontierSize = job->levelEnd - job->levelStart;
+
+	if (!job->bottomUp && job->frontierEdges > job->unvisitedEdges / BOTTOM_UP_ALPHA) {
+		job->bottomUp = 1;
+	} else if (job->bottomUp && frontierSize < g->csr.numActors / TOP_DOWN_BETA) {
+		job->bottomUp = 0;
+	}
+
+	if (frontierSize == 0) {
+		job->phase = PHASE_DONE;
+	} else {
+		job->phase = job->bottomUp ? PHASE_MOVIES : PHASE_TOP_DOWN;
+	}
+	atomic_store(&job->cursor, 0);
+}
+
+
+
+/*
+* bfsRun(worker) -- runs the steps of one parallel BFS until it is done.
+* worker: pointer to this thread's bfsWorker.
+* Returns: void.
+* Assumptions: every thread of the job runs this for the same search.
+* Side effects: works on every step; worker 0 also advances the job between steps.
+*/
+void bfsRun(struct bfsWorker *worker) {
+
+	struct bfsJob *job = worker->job;
+
+	for (;;) {
+		pthread_barrier_wait(&job->barrier);
+		if (job->phase == PHASE_DONE) {
+			break;
+		}
+		bfsStep(worker);
+		pthread_barrier_wait(&job->barrier);
+		if (worker == &job->workers[0]) {
+			bfsAdvance(job);
+		}
+	}
+}
+
+
+
+/*
+* bfsThread(arg) -- works on every full search of a graph until it is closed.
+* arg: pointer to this thread's bfsWorker.
+* Returns: NULL.
+* Assumptions: the job's barrier counts every thread that runs this, plus the caller
+*              of BFSAll.
+* Side effects: waits at the barrier between searches.
+*/
+void* bfsThread(void *arg) {
+
+	struct bfsWorker *worker = arg;
+	struct bfsJob *job = worker->job;
+
+	// Wait until the barrier knows how many workers actually started
+	pthread_mutex_lock(&job->gate);
+	pthread_mutex_unlock(&job->gate);
+
+	for (;;) {
+		// BFSAll has set up the next search, or stopBFSPool the shutdown
+		pthread_barrier_wait(&job->barrier);
+		if (job->phase == PHASE_EXIT) {
+			break;
+		}
+		bfsRun(worker);
+
+		// Keeps BFSAll from setting up the next search while this thread still reads the job
+		pthread_barrier_wait(&job->barrier);
+	}
+	return NULL;
+}
+
+
+
+/*
+* startBFSPool(g) -- starts the threads that run the full searches of a graph.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: called once, with bfsLock held.
+* Side effects: allocates bfsPool and starts up to g->threads - 1 threads (one per CPU
+*               by default, fewer on small graphs); the caller of BFSAll is the last
+*               worker. The threads start with every signal blocked, so signals keep
+*               going to the program's own threads.
+*/
+void startBFSPool(struct bacon_graph *g) {
+
+	long threads = g->threads > 0 ? g->threads : sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (g->threads == 0 && threads > (long) (g->csr.numActors / BFS_ACTORS_PER_THREAD) + 1) {
+		threads = g->csr.numActors / BFS_ACTORS_PER_THREAD + 1;
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	struct bfsPool *pool = calloc(1, sizeof(struct bfsPool));
+
+	if (pool == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	struct bfsJob *job = &pool->job;
+	job->workers = calloc(threads, sizeof(struct bfsWorker));
+	pool->handles = calloc(threads, sizeof(pthread_t));
+
+	if (job->workers == NULL || pool->handles == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	// Workers that fail to start are left out of the barrier and the job
+	pthread_mutex_init(&job->gate, NULL);
+	pthread_mutex_lock(&job->gate);
+
+	sigset_t allSignals;
+	sigset_t oldMask;
+	sigfillset(&allSignals);
+	pthread_sigmask(SIG_SETMASK, &allSignals, &oldMask);
+
+	long started = 1;
+	job->workers[0].job = job;
+	for (long index = 1; index < threads; index++) {
+		job->workers[started].job = job;
+		if (pthread_create(&pool->handles[started], NULL, bfsThread, &job->workers[started]) == 0) {
+			started++;
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+
+	job->threads = started;
+	pthread_barrier_init(&job->barrier, NULL, (unsigned) started);
+	pthread_mutex_unlock(&job->gate);
+	g->bfsPool = pool;
+}
+
+
+
+/*
+* stopBFSPool(g) -- stops the full-search threads of a graph.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: no BFSAll is running on g.
+* Side effects: joins the threads and frees bfsPool, if it was started.
+*/
+void stopBFSPool(struct bacon_graph *g) {
+
+	struct bfsPool *pool = g->bfsPool;
+
+	if (pool == NULL) {
+		return;
+	}
+
+	struct bfsJob *job = &pool->job;
+	job->phase = PHASE_EXIT;
+	pthread_barrier_wait(&job->barrier);
+
+	for (long index = 1; index < job->threads; index++) {
+		pthread_join(pool->handles[index], NULL);
+	}
+	for (long index = 0; index < job->threads; index++) {
+		free(job->workers[index].found);
+	}
+	pthread_barrier_destroy(&job->barrier);
+	pthread_mutex_destroy(&job->gate);
+	free(job->workers);
+	free(pool->handles);
+	free(pool);
+	g->bfsPool = NULL;
+}
+
+
+
+/*
+* BFSAll(state, start, distances, parents, parentMovies) -- performs a full
+*                             Breadth-First Search from one actor, recording the degrees
+*                             of separation to every actor and the BFS tree.
+* state: pointer to the searchState whose movie stamps, movie parents and queue
+*        buffer are reused.
+* start: ID of the starting actor.
+* distances: array of g->csr.numActors entries to fill.
+* parents: array of g->csr.numActors entries to receive, for each reached actor,
+*          the actor it was reached through.
+* parentMovies: array of g->csr.numActors entries to receive the movie shared
+*               with that parent.
+* Returns: void.
+* Assumptions: buildGraph has run and start is a valid ID.
+* Side effects: overwrites distances (-1 for unreachable actors) and the parent
+*               arrays, starts a new epoch in state for its movie stamps and runs
+*               on the graph's pool of search threads, starting it on the first call
+*               (see startBFSPool). Full searches on one graph run one at a time.
+*
+* The search is level-synchronous: all threads expand one level, meet at a barrier,
+* and the coordinating thread joins their next-frontier buffers. Levels are expanded
+* top-down (frontier actors push to their movies' casts) while the frontier is
+* small and bottom-up (unvisited movies and actors look for a reached neighbour and
+* stop at the first one) while it covers a large part of the graph, which skips
+* most edges of the crowded middle levels. Distances never depend on the thread
+* count or the direction; only the choice among equally short parents may.
+*/
+void BFSAll(struct searchState *state, uint32_t start, int *distances, uint32_t *parents,
+		uint32_t *parentMovies) {
+
+	const struct bacon_graph *g = state->graph;
+
+    	// Every entry is written anyway, so distances double as the actor marks
+    	for (uint32_t id = 0; id < g->csr.numActors; id++) {
+        	distances[id] = -1;
+    	}
+
+	// The pool only serves searches, so using it leaves the graph logically const
+	struct bacon_graph *shared = (struct bacon_graph *) g;
+
+	pthread_mutex_lock(&shared->bfsLock);
+	if (shared->bfsPool == NULL) {
+		startBFSPool(shared);
+	}
+
+	struct bfsJob *job = &shared->bfsPool->job;
+	job->graph = g;
+	job->distances = distances;
+	job->parents = parents;
+	job->parentMovies = parentMovies;
+	job->epoch = beginSearch(state);
+	job->movieStamps = state->movieStamps;
+	job->movieParents = state->movieParents;
+
+	// The queue buffer holds every actor, and each actor is reached once
+	job->order = state->queue.items;
+	job->order[0] = start;
+	distances[start] = 0;
+	job->levelStart = 0;
+	job->levelEnd = 1;
+	job->level = 0;
+	job->frontierEdges = g->csr.actorOffsets[start + 1] - g->csr.actorOffsets[start];
+	job->unvisitedEdges = g->csr.numEdges - job->frontierEdges;
+	job->bottomUp = job->frontierEdges > job->unvisitedEdges / BOTTOM_UP_ALPHA;
+	job->phase = job->bottomUp ? PHASE_MOVIES : PHASE_TOP_DOWN;
+	atomic_store(&job->cursor, 0);
+
+	// Same two waits as every pool thread: release them, then wait until they let go
+	pthread_barrier_wait(&job->barrier);
+	bfsRun(&job->workers[0]);
+	pthread_barrier_wait(&job->barrier);
+	pthread_mutex_unlock(&shared->bfsLock);
+}
+
+
+
+
+/*
+* multiSourceBFS(g, sources, count, stats) -- runs up to MSBFS_WIDTH full Breadth-First
+*                             Searches at once, one bit lane per source.
+* g: pointer to the graph.
+* sources: array of count actor IDs to search from.
+* count: number of sources, at most MSBFS_WIDTH.
+* stats: array of count centerStats to fill, one per source.
+* Returns: void.
+* Assumptions: buildGraph has run and every source is a valid ID.
+* Side effects: overwrites stats; temporarily allocates per-actor and per-movie masks.
+*
+* Every actor keeps a mask of the sources that have seen it and of those whose
+* frontier it is on. Each level ORs the frontier masks into the movies, then the
+* movie masks into their casts, so one sweep over the CSR arrays advances all of
+* the searches and the adjacency is read once per level instead of once per source.
+* The word loops are plain enough for the compiler to turn into SIMD ORs.
+*/
+void multiSourceBFS(const struct bacon_graph *g, const uint32_t *sources, uint32_t count, struct centerStats *stats) {
+
+	size_t actorWords = (size_t) g->csr.numActors * MSBFS_WORDS;
+	uint64_t *seen = calloc(actorWords + MSBFS_WORDS, sizeof(uint64_t));
+	uint64_t *frontier = calloc(actorWords + MSBFS_WORDS, sizeof(uint64_t));
+	uint64_t *next = calloc(actorWords + MSBFS_WORDS, sizeof(uint64_t));
+	uint64_t *movieMasks = calloc(((size_t) g->csr.numMovies + 1) * MSBFS_WORDS, sizeof(uint64_t));
+
+	if (seen == NULL || frontier == NULL || next == NULL || movieMasks == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	for (uint32_t lane = 0; lane < count; lane++) {
+		uint64_t bit = 1ULL << (lane % 64);
+		seen[(size_t) sources[lane] * MSBFS_WORDS + lane / 64] |= bit;
+		frontier[(size_t) sources[lane] * MSBFS_WORDS + lane / 64] |= bit;
+		stats[lane].reachable = 0;
+		stats[lane].totalDistance = 0;
+		stats[lane].eccentricity = 0;
+	}
+
+	int active = count > 0;
+
+	for (uint32_t level = 1; active; level++) {
+
+		memset(movieMasks, 0, (size_t) g->csr.numMovies * MSBFS_WORDS * sizeof(uint64_t));
+
+		// Actors -> movies
+		for (uint32_t a = 0; a < g->csr.numActors; a++) {
+			const uint64_t *mask = &frontier[(size_t) a * MSBFS_WORDS];
+			uint64_t any = 0;
+
+			for (int word = 0; word < MSBFS_WORDS; word++) {
+				any |= mask[word];
+			}
+			if (any == 0) {
+				continue;
+			}
+
+			for (uint32_t ml = g->csr.actorOffsets[a]; ml < g->csr.actorOffsets[a + 1]; ml++) {
+				uint64_t *target = &movieMasks[(size_t) g->csr.actorMovies[ml] * MSBFS_WORDS];
+				for (int word = 0; word < MSBFS_WORDS; word++) {
+					target[word] |= mask[word];
+				}
+			}
+		}
+
+		// Movies -> casts
+		for (uint32_t movie = 0; movie < g->csr.numMovies; movie++) {
+			const uint64_t *mask = &movieMasks[(size_t) movie * MSBFS_WORDS];
+			uint64_t any = 0;
+
+			for (int word = 0; word < MSBFS_WORDS; word++) {
+				any |= mask[word];
+			}
+			if (any == 0) {
+				continue;
+			}
+
+			for (uint32_t co = g->csr.movieOffsets[movie]; co < g->csr.movieOffsets[movie + 1]; co++) {
+				uint64_t *target = &next[(size_t) g->csr.movieActors[co] * MSBFS_WORDS];
+				for (int word = 0; word < MSBFS_WORDS; word++) {
+					target[word] |= mask[word];
+				}
+			}
+		}
+
+		// Keep only first visits; they form the next frontier
+		active = 0;
+		for (uint32_t a = 0; a < g->csr.numActors; a++) {
+			size_t base = (size_t) a * MSBFS_WORDS;
+
+			for (int word = 0; word < MSBFS_WORDS; word++) {
+				uint64_t fresh = next[base + word] & ~seen[base + word];
+
+				next[base + word] = 0;
+				frontier[base + word] = fresh;
+				seen[base + word] |= fresh;
+
+				while (fresh != 0) {
+					struct centerStats *lane = &stats[word * 64 + __builtin_ctzll(fresh)];
+					lane->reachable++;
+					lane->totalDistance += level;
+					lane->eccentricity = level;
+					active = 1;
+					fresh &= fresh - 1;
+				}
+			}
+		}
+	}
+
+	free(seen);
+	free(frontier);
+	free(next);
+	free(movieMasks);
+}
+
+
+
+
+/*
+ * labelList -- One actor's label while the label index is being built.
+ *
+ * Fields:
+ *   hubs      - Ranks of the hubs, ascending.
+ *   distances - Distance to each hub.
+ *   count     - Number of entries.
+ *   capacity  - Allocated entries.
+ */
+struct labelList {
+	uint32_t *hubs;
+	uint8_t *distances;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+/*
+ * rankedActor -- An actor and the degree it is ordered by when picking hubs.
+ *
+ * Fields:
+ *   degree - Number of cast mates summed over the actor's movies.
+ *   actor  - ID of the actor.
+ */
+struct rankedActor {
+	uint64_t degree;
+	uint32_t actor;
+};
+
+
+
+/*
+* compareRanked(a, b) -- orders rankedActors by decreasing degree, then by ID.
+* a: pointer to the first rankedActor.
+* b: pointer to the second rankedActor.
+* Returns: a negative, zero or positive value as for qsort.
+* Assumptions: none.
+* Side effects: none.
+*/
+int compareRanked(const void *a, const void *b) {
+
+	const struct rankedActor *left = a;
+	const struct rankedActor *right = b;
+
+	if (left->degree != right->degree) {
+		return left->degree > right->degree ? -1 : 1;
+	}
+	return left->actor < right->actor ? -1 : left->actor > right->actor;
+}
+
+
+
+/*
+* graphHash(g) -- fingerprints the adjacency of the graph.
+* g: pointer to the graph.
+* Returns: a 64-bit hash of both CSR offset arrays and the movie casts.
+* Assumptions: the graph is ready.
+* Side effects: none.
+*/
+uint64_t graphHash(const struct bacon_graph *g) {
+
+	uint64_t hash = hashName((const char *) g->csr.actorOffsets, ((size_t) g->csr.numActors + 1) * sizeof(uint32_t));
+	hash = hash * 31 + hashName((const char *) g->csr.movieOffsets, ((size_t) g->csr.numMovies + 1) * sizeof(uint32_t));
+	hash = hash * 31 + hashName((const char *) g->csr.movieActors, (size_t) g->csr.numEdges * sizeof(uint32_t));
+	return hash;
+}
+
+
+
+/*
+* buildLabels(g) -- builds the pruned landmark label index of the actor graph.
+* g: pointer to the graph.
+* Returns: 0 on success, -1 if some distance is too long to be stored.
+* Assumptions: the graph is ready.
+* Side effects: on success allocates labelOffsets, labelHubs and labelDistances;
+*               uses a private search state for the searches.
+*
+* Actors are taken in decreasing degree order, and each runs a BFS that records its
+* rank and distance in the label of every actor it reaches, except that an actor
+* whose distance the labels built so far already give is neither labelled nor
+* expanded. Hubs come first in this order, so most searches stop after a few
+* levels and labels stay short. Any shortest path then passes through a hub the two
+* labels share, which is what labelDistance relies on.
+*/
+int buildLabels(struct bacon_graph *g) {
+
+	uint32_t count = g->csr.numActors;
+	struct rankedActor *ranked = malloc(((size_t) count + 1) * sizeof(struct rankedActor));
+	struct labelList *labels = calloc((size_t) count + 1, sizeof(struct labelList));
+	uint8_t *rootDistances = malloc((size_t) count + 1);
+
+	if (ranked == NULL || labels == NULL || rootDistances == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	for (uint32_t a = 0; a < count; a++) {
+		ranked[a].actor = a;
+		ranked[a].degree = 0;
+		for (uint32_t ml = g->csr.actorOffsets[a]; ml < g->csr.actorOffsets[a + 1]; ml++) {
+			uint32_t movie = g->csr.actorMovies[ml];
+			ranked[a].degree += g->csr.movieOffsets[movie + 1] - g->csr.movieOffsets[movie] - 1;
+		}
+	}
+	qsort(ranked, count, sizeof(struct rankedActor), compareRanked);
+	memset(rootDistances, UINT8_MAX, (size_t) count + 1);
+
+	struct searchState search;
+	struct searchState *state = &search;
+	int failed = 0;
+
+	initSearchState(g, state);
+
+	for (uint32_t rank = 0; rank < count && !failed; rank++) {
+		uint32_t root = ranked[rank].actor;
+		struct labelList *rootLabel = &labels[root];
+
+		// The root's distance to each earlier hub, indexed by hub rank
+		for (uint32_t entry = 0; entry < rootLabel->count; entry++) {
+			rootDistances[rootLabel->hubs[entry]] = rootLabel->distances[entry];
+		}
+
+		uint32_t epoch = beginSearch(state);
+		state->actorStamps[root] = epoch;
+		state->levels[root] = 0;
+		enqueue(&state->queue, root);
+
+		while (state->queue.count > 0) {
+			uint32_t a = dequeue(&state->queue);
+			int level = state->levels[a];
+			struct labelList *label = &labels[a];
+
+			// Prune: the earlier hubs already give a path this short
+			int covered = 0;
+			for (uint32_t entry = 0; entry < label->count && !covered; entry++) {
+				uint8_t viaHub = rootDistances[label->hubs[entry]];
+				covered = viaHub != UINT8_MAX && viaHub + label->distances[entry] <= level;
+			}
+			if (covered) {
+				continue;
+			}
+
+			if (level > LABEL_MAX_DISTANCE) {
+				failed = 1;
+				break;
+			}
+
+			if (label->count == label->capacity) {
+				label->capacity = label->capacity == 0 ? 4 : label->capacity * 2;
+				label->hubs = realloc(label->hubs, label->capacity * sizeof(uint32_t));
+				label->distances = realloc(label->distances, label->capacity);
+
+				if (label->hubs == NULL || label->distances == NULL) {
+					fprintf(stderr, "Not Enough Memory.\n");
+					exit(1);
+				}
+			}
+			label->hubs[label->count] = rank;
+			label->distances[label->count] = (uint8_t) level;
+			label->count++;
+
+			for (uint32_t ml = g->csr.actorOffsets[a]; ml < g->csr.actorOffsets[a + 1]; ml++) {
+				uint32_t movie = g->csr.actorMovies[ml];
+
+				if (state->movieStamps[movie] == epoch) {
+					continue;
+				}
+				state->movieStamps[movie] = epoch;
+
+				for (uint32_t co = g->csr.movieOffsets[movie]; co < g->csr.movieOffsets[movie + 1]; co++) {
+					uint32_t c = g->csr.movieActors[co];
+
+					if (state->actorStamps[c] != epoch) {
+						state->actorStamps[c] = epoch;
+						state->levels[c] = level + 1;
+						enqueue(&state->queue, c);
+					}
+				}
+			}
+		}
+
+		for (uint32_t entry = 0; entry < rootLabel->count; entry++) {
+			rootDistances[rootLabel->hubs[entry]] = UINT8_MAX;
+		}
+	}
+
+	// Pack the lists into one array per field
+	uint64_t numEntries = 0;
+	for (uint32_t a = 0; a < count; a++) {
+		numEntries += labels[a].count;
+	}
+
+	if (!failed) {
+		g->labelOffsets = malloc(((size_t) count + 1) * sizeof(uint64_t));
+		g->labelHubs = malloc((numEntries + 1) * sizeof(uint32_t));
+		g->labelDistances = malloc(numEntries + 1);
+
+		if (g->labelOffsets == NULL || g->labelHubs == NULL || g->labelDistances == NULL) {
+			fprintf(stderr, "Not Enough Memory.\n");
+			exit(1);
+		}
+
+		uint64_t next = 0;
+		for (uint32_t a = 0; a < count; a++) {
+			g->labelOffsets[a] = next;
+			memcpy(&g->labelHubs[next], labels[a].hubs, labels[a].count * sizeof(uint32_t));
+			memcpy(&g->labelDistances[next], labels[a].distances, labels[a].count);
+			next += labels[a].count;
+		}
+		g->labelOffsets[count] = next;
+	}
+
+	for (uint32_t a = 0; a < count; a++) {
+		free(labels[a].hubs);
+		free(labels[a].distances);
+	}
+	free(labels);
+	free(ranked);
+	free(rootDistances);
+	freeSearchState(state);
+	return failed ? -1 : 0;
+}
+
+
+
+/*
+* saveLabels(g, path) -- writes the label index to a file.
+* g: pointer to the graph.
+* path: pointer to a string containing the file's path.
+* Returns: 0 on success, -1 if the file could not be written.
+* Assumptions: the label index is loaded or built.
+* Side effects: creates or overwrites the file.
+*/
+int saveLabels(const struct bacon_graph *g, const char *path) {
+
+	FILE *out = fopen(path, "wb");
+
+	if (out == NULL) {
+		return -1;
+	}
+
+	struct labelIndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LABEL_MAGIC, sizeof(header.magic));
+	header.version = LABEL_VERSION;
+	header.numActors = g->csr.numActors;
+	header.graphHash = graphHash(g);
+	header.numEntries = g->labelOffsets[g->csr.numActors];
+
+	static const char padding[8] = { 0 };
+	size_t pad = (8 - header.numEntries * sizeof(uint32_t) % 8) % 8;
+
+	int failed = fwrite(&header, sizeof(header), 1, out) != 1
+		|| fwrite(g->labelOffsets, sizeof(uint64_t), (size_t) g->csr.numActors + 1, out) != (size_t) g->csr.numActors + 1
+		|| fwrite(g->labelHubs, sizeof(uint32_t), header.numEntries, out) != header.numEntries
+		|| fwrite(padding, 1, pad, out) != pad
+		|| fwrite(g->labelDistances, 1, header.numEntries, out) != header.numEntries;
+
+	if (fclose(out) != 0 || failed) {
+		return -1;
+	}
+	return 0;
+}
+
+
+
+/*
+* loadLabels(g, path) -- maps a label index file written for the current graph.
+* g: pointer to the graph.
+* path: pointer to a string containing the file's path.
+* Returns: 0 on success, -1 if the file is missing, truncated, of another version,
+*          built for a different graph or has label offsets out of order.
+* Assumptions: the graph is ready and no label index is in use.
+* Side effects: maps the file read-only into labelMap and points labelOffsets,
+*               labelHubs and labelDistances into it.
+*/
+int loadLabels(struct bacon_graph *g, const char *path) {
+
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return -1;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(struct labelIndexHeader)) {
+		close(fd);
+		return -1;
+	}
+
+	void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED) {
+		return -1;
+	}
+
+	const struct labelIndexHeader *header = map;
+	uint64_t size = info.st_size;
+	uint64_t hubsStart = sizeof(struct labelIndexHeader) + ((uint64_t) g->csr.numActors + 1) * sizeof(uint64_t);
+	uint64_t distancesStart = hubsStart + (header->numEntries * sizeof(uint32_t) + 7) / 8 * 8;
+
+	if (memcmp(header->magic, LABEL_MAGIC, sizeof(header->magic)) != 0 || header->version != LABEL_VERSION
+			|| header->numActors != g->csr.numActors || header->numEntries > size
+			|| distancesStart > size || header->numEntries > size - distancesStart
+			|| header->graphHash != graphHash(g)) {
+		munmap(map, info.st_size);
+		return -1;
+	}
+
+	// The hash only covers the graph, so the offsets must be checked before labelDistance trusts them
+	const uint64_t *offsets = (const uint64_t *) ((char *) map + sizeof(struct labelIndexHeader));
+	uint64_t decreases = 0;
+
+	for (uint32_t a = 0; a < g->csr.numActors; a++) {
+		decreases |= offsets[a] > offsets[a + 1];
+	}
+	if (offsets[0] != 0 || offsets[g->csr.numActors] != header->numEntries || decreases) {
+		munmap(map, info.st_size);
+		return -1;
+	}
+
+	g->labelMap = map;
+	g->labelMapSize = info.st_size;
+	g->labelOffsets = (uint64_t *) ((char *) map + sizeof(struct labelIndexHeader));
+	g->labelHubs = (uint32_t *) ((char *) map + hubsStart);
+	g->labelDistances = (uint8_t *) map + distancesStart;
+	return 0;
+}
+
+
+
+/*
+* freeLabels(g) -- releases the label index.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: none.
+* Side effects: unmaps the label file or frees the built arrays.
+*/
+void freeLabels(struct bacon_graph *g) {
+
+	if (g->labelMap != NULL) {
+		munmap(g->labelMap, g->labelMapSize);
+		g->labelMap = NULL;
+	} else {
+		free(g->labelOffsets);
+		free(g->labelHubs);
+		free(g->labelDistances);
+	}
+	g->labelOffsets = NULL;
+	g->labelHubs = NULL;
+	g->labelDistances = NULL;
+}
+
+
+
+/*
+* labelDistance(g, from, to) -- computes the exact distance between two actors from their labels.
+* g: pointer to the graph.
+* from: ID of the first actor.
+* to: ID of the second actor.
+* Returns: the degrees of separation, or -1 if the actors are not connected.
+* Assumptions: the label index is in use.
+* Side effects: none.
+*
+* Both labels are sorted by hub rank, so one merge finds every shared hub.
+*/
+int labelDistance(const struct bacon_graph *g, uint32_t from, uint32_t to) {
+
+	uint64_t i = g->labelOffsets[from];
+	uint64_t iEnd = g->labelOffsets[from + 1];
+	uint64_t j = g->labelOffsets[to];
+	uint64_t jEnd = g->labelOffsets[to + 1];
+	int best = -1;
+
+	while (i < iEnd && j < jEnd) {
+		if (g->labelHubs[i] < g->labelHubs[j]) {
+			i++;
+		} else if (g->labelHubs[i] > g->labelHubs[j]) {
+			j++;
+		} else {
+			int distance = g->labelDistances[i] + g->labelDistances[j];
+			if (best == -1 || distance < best) {
+				best = distance;
+			}
+			i++;
+			j++;
+		}
+	}
+	return best;
+}
+
+
+
+
+/*
+* printConnection(g, out, actor, movie, next) -- prints one link of a connection path.
+* g: pointer to the graph.
+* out: pointer to the output stream.
+* actor: ID of the actor the link starts at.
+* movie: ID of the movie both actors appear in.
+* next: ID of the actor the link ends at.
+* Returns: void.
+* Assumptions: all IDs are valid.
+* Side effects: writes an "A was in M with B" line to out.
+*/
+void printConnection(const struct bacon_graph *g, FILE *out, uint32_t actor, uint32_t movie, uint32_t next) {
+	printName(g, out, g->actorNames[actor]);
+	fputs(" was in ", out);
+	printName(g, out, g->movieNames[movie]);
+	fputs(" with ", out);
+	printName(g, out, g->actorNames[next]);
+	fputc('\n', out);
+}
+
+
+
+/*
+* printPath(g, out, from, to, parents, parentMovies) -- prints the chain of shared movies
+*                             leading from one actor to another along a BFS tree.
+* g: pointer to the graph.
+* out: pointer to the output stream.
+* from: ID of the actor the chain starts at.
+* to: ID of the BFS source the chain ends at.
+* parents: per-actor parent actor IDs of a BFS rooted at to.
+* parentMovies: per-actor IDs of the movie shared with the parent.
+* Returns: void.
+* Assumptions: from was reached by that BFS, so following parents ends at to.
+* Side effects: writes one "A was in M with B" line per connection to out.
+*/
+void printPath(const struct bacon_graph *g, FILE *out, uint32_t from, uint32_t to, const uint32_t *parents, const uint32_t *parentMovies) {
+
+	while (from != to) {
+		uint32_t next = parents[from];
+		printConnection(g, out, from, parentMovies[from], next);
+		from = next;
+	}
+}
+
+
+
+
+/*
+* printPairPath(out, forward, backward, target, meet) -- prints the chain of shared
+*                             movies found by a bidirectional BFS, from its start to target.
+* out: pointer to the output stream.
+* forward: pointer to the searchState that was rooted at the start.
+* backward: pointer to the searchState that was rooted at target.
+* target: ID of the actor the backward search was rooted at.
+* meet: ID of the actor where the two searches met.
+* Returns: void.
+* Assumptions: BFS(forward, backward, start, target, &meet) was the last search on
+*              these states and found a path.
+* Side effects: writes one "A was in M with B" line per connection to out;
+*               temporarily allocates the forward half of the chain.
+*/
+void printPairPath(FILE *out, const struct searchState *forward, const struct searchState *backward,
+		uint32_t target, uint32_t meet) {
+
+	const struct bacon_graph *g = forward->graph;
+
+	// Forward parents point back toward start, so collect that half and reverse it
+	int length = forward->levels[meet];
+	uint32_t *chain = malloc(((size_t) length + 1) * sizeof(uint32_t));
+
+	if (chain == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	uint32_t cur = meet;
+	for (int index = length; index >= 0; index--) {
+		chain[index] = cur;
+		cur = forward->parents[cur];
+	}
+
+	for (int index = 0; index < length; index++) {
+		uint32_t next = chain[index + 1];
+		printConnection(g, out, chain[index], forward->parentMovies[next], next);
+	}
+	free(chain);
+
+	printPath(g, out, meet, target, backward->parents, backward->parentMovies);
+}
+
+
+
+// Trigram index size: between 2^TRIGRAM_MIN_BITS and 2^TRIGRAM_MAX_BITS buckets
+#define TRIGRAM_MIN_BITS 10
+#define TRIGRAM_MAX_BITS 22
+
+// List entries suggestActors reads before it only binary searches the longer lists
+#define SUGGEST_SCAN_BUDGET (1 << 16)
+
+// Least similarity (shared trigrams over all trigrams of the two names) worth suggesting
+#define SUGGEST_MIN_SIMILARITY 0.3
+
+
+/*
+* nameTrigrams(g, name, length, buckets) -- lists the distinct trigram buckets of a name.
+* g: pointer to the graph.
+* name: pointer to a name already passed through foldName.
+* length: length of the name in bytes.
+* buckets: array of at least length + 1 entries to receive the buckets, in increasing order.
+* Returns: the number of distinct buckets.
+* Assumptions: g->trigramBits is set.
+* Side effects: writes to buckets.
+*
+* The name is padded as "  name " so that its first letters and its end count as
+* trigrams too, which lets short names and near misses at either end match.
+*/
+uint32_t nameTrigrams(const struct bacon_graph *g, const char *name, size_t length, uint32_t *buckets) {
+
+	uint32_t count = 0;
+	uint32_t window = ((uint32_t) ' ' << 8) | ' ';
+
+	for (size_t index = 0; index <= length; index++) {
+		unsigned char c = index < length ? name[index] : ' ';
+
+		window = ((window << 8) | c) & 0xFFFFFF;
+		uint32_t bucket = (window * 0x9E3779B1u) >> (32 - g->trigramBits);
+
+		// Insertion keeps the list sorted and drops repeats; names are short
+		uint32_t at = count;
+		while (at > 0 && buckets[at - 1] > bucket) {
+			at--;
+		}
+		if (at > 0 && buckets[at - 1] == bucket) {
+			continue;
+		}
+		memmove(buckets + at + 1, buckets + at, (count - at) * sizeof(uint32_t));
+		buckets[at] = bucket;
+		count++;
+	}
+	return count;
+}
+
+
+
+/*
+* buildTrigrams(g) -- builds the trigram index that suggestActors searches.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: the graph is ready and no search is using it yet.
+* Side effects: allocates trigramOffsets, trigramActors and trigramCounts. The
+*               index holds one entry per distinct trigram of every actor name,
+*               about four bytes per byte of actor names.
+*
+* Trigrams are hashed into about one bucket per actor (TRIGRAM_MAX_BITS at most),
+* and each bucket lists the actors having one of its trigrams in increasing ID
+* order. Two passes over the names, one to count and one to fill, avoid growing
+* any list.
+*/
+void buildTrigrams(struct bacon_graph *g) {
+
+	uint32_t numActors = g->csr.numActors;
+
+	g->trigramBits = TRIGRAM_MIN_BITS;
+	while (g->trigramBits < TRIGRAM_MAX_BITS && (1u << g->trigramBits) < numActors) {
+		g->trigramBits++;
+	}
+
+	size_t numBuckets = (size_t) 1 << g->trigramBits;
+	uint64_t *cursors = calloc(numBuckets, sizeof(uint64_t));
+	g->trigramOffsets = calloc(numBuckets + 1, sizeof(uint64_t));
+	g->trigramCounts = malloc(((size_t) numActors + 1) * sizeof(uint16_t));
+
+	char *folded = NULL;
+	uint32_t *buckets = NULL;
+	size_t capacity = 0;
+
+	if (cursors == NULL || g->trigramOffsets == NULL || g->trigramCounts == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	for (int pass = 0; pass < 2; pass++) {
+		for (uint32_t id = 0; id < numActors; id++) {
+			struct nameRef name = g->actorNames[id];
+
+			if (name.length + 1 > capacity) {
+				capacity = (name.length + 1) * 2;
+				free(folded);
+				free(buckets);
+				folded = malloc(capacity);
+				buckets = malloc(capacity * sizeof(uint32_t));
+
+				if (folded == NULL || buckets == NULL) {
+					fprintf(stderr, "Not Enough Memory.\n");
+					exit(1);
+				}
+			}
+
+			size_t length = foldName(g->nameBase + name.offset, name.length, folded);
+			uint32_t count = nameTrigrams(g, folded, length, buckets);
+
+			for (uint32_t index = 0; index < count; index++) {
+				if (pass == 0) {
+					g->trigramOffsets[buckets[index] + 1]++;
+				} else {
+					g->trigramActors[cursors[buckets[index]]++] = id;
+				}
+			}
+			g->trigramCounts[id] = count > UINT16_MAX ? UINT16_MAX : count;
+		}
+
+		if (pass == 0) {
+			for (size_t bucket = 0; bucket < numBuckets; bucket++) {
+				g->trigramOffsets[bucket + 1] += g->trigramOffsets[bucket];
+				cursors[bucket] = g->trigramOffsets[bucket];
+			}
+			g->trigramActors = malloc((g->trigramOffsets[numBuckets] + 1) * sizeof(uint32_t));
+
+			if (g->trigramActors == NULL) {
+				fprintf(stderr, "Not Enough Memory.\n");
+				exit(1);
+			}
+		}
+	}
+	free(folded);
+	free(buckets);
+	free(cursors);
+}
+
+
+
+/*
+* freeNameIndex(g) -- releases the folded-name table and the trigram index.
+* g: pointer to the graph.
+* Returns: void.
+* Assumptions: none.
+* Side effects: deallocates whichever of them were built.
+*/
+void freeNameIndex(struct bacon_graph *g) {
+	free(g->foldSlots);
+	free(g->trigramOffsets);
+	free(g->trigramActors);
+	free(g->trigramCounts);
+	g->foldSlots = NULL;
+	g->foldReady = 0;
+	g->trigramOffsets = NULL;
+	g->trigramActors = NULL;
+	g->trigramCounts = NULL;
+}
+
+
+
+/*
+* trigramList -- One trigram bucket of a query, for ordering by list length.
+*
+* Fields:
+*   bucket - The bucket.
+*   length - Number of actors it lists.
+*/
+struct trigramList {
+	uint32_t bucket;
+	uint64_t length;
+};
+
+
+
+/*
+* compareTrigramLists(a, b) -- orders trigram buckets from shortest to longest list for qsort.
+* a: pointer to the first trigramList.
+* b: pointer to the second trigramList.
+* Returns: negative, zero or positive as a's list is shorter, as long or longer.
+* Assumptions: none.
+* Side effects: none.
+*/
+int compareTrigramLists(const void *a, const void *b) {
+
+	const struct trigramList *x = a;
+	const struct trigramList *y = b;
+
+	return (x->length > y->length) - (x->length < y->length);
+}
+
+
+
+/*
+* listsActor(g, bucket, actor) -- checks whether a trigram bucket lists an actor.
+* g: pointer to the graph.
+* bucket: the bucket.
+* actor: ID of the actor.
+* Returns: 1 if it does, 0 otherwise.
+* Assumptions: the trigram index is built.
+* Side effects: none.
+*/
+int listsActor(const struct bacon_graph *g, uint32_t bucket, uint32_t actor) {
+
+	uint64_t low = g->trigramOffsets[bucket];
+	uint64_t high = g->trigramOffsets[bucket + 1];
+
+	while (low < high) {
+		uint64_t middle = low + (high - low) / 2;
+
+		if (g->trigramActors[middle] < actor) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low < g->trigramOffsets[bucket + 1] && g->trigramActors[low] == actor;
+}
+
+
+
+/*
+* suggestActors(state, name, length, ids, k) -- finds the actors whose names are
+*                             most similar to a name that was not found.
+* state: pointer to the calling thread's searchState, used as scratch space.
+* name: pointer to the first byte of the name as typed.
+* length: length of the name in bytes.
+* ids: array of k entries to receive the actor IDs, most similar first.
+* k: largest number of suggestions wanted.
+* Returns: the number of IDs written, 0 if the trigram index is not built.
+* Assumptions: no search is running on state.
+* Side effects: starts a new epoch in state and uses its levels as counters and its
+*               queue as the candidate list; temporarily allocates the query's trigrams.
+*
+* Similarity is the Jaccard index of the two sets of trigram buckets, and names
+* below SUGGEST_MIN_SIMILARITY are left out. Common
+* trigrams have long lists, so the shortest lists are scanned first to pick the
+* candidates, until SUGGEST_SCAN_BUDGET entries have been read; the remaining,
+* longer lists are only binary searched for the candidates that could still make
+* the top k, best first. Names sharing no trigram from the scanned lists are not
+* considered.
+*/
+int suggestActors(struct searchState *state, const char *name, size_t length, uint32_t *ids, int k) {
+
+	const struct bacon_graph *g = state->graph;
+
+	if (g->trigramOffsets == NULL || k < 1) {
+		return 0;
+	}
+
+	char *folded = malloc(length + 1);
+	uint32_t *buckets = malloc((length + 1) * sizeof(uint32_t));
+	struct trigramList *lists = malloc((length + 1) * sizeof(struct trigramList));
+	double *scores = malloc(k * sizeof(double));
+
+	if (folded == NULL || buckets == NULL || lists == NULL || scores == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	uint32_t count = nameTrigrams(g, folded, foldName(name, length, folded), buckets);
+
+	for (uint32_t index = 0; index < count; index++) {
+		lists[index].bucket = buckets[index];
+		lists[index].length = g->trigramOffsets[buckets[index] + 1] - g->trigramOffsets[buckets[index]];
+	}
+	qsort(lists, count, sizeof(struct trigramList), compareTrigramLists);
+
+	// Count shared trigrams over the shortest lists; every actor seen is a candidate
+	uint32_t epoch = beginSearch(state);
+	uint64_t scanned = 0;
+	uint32_t used = 0;
+
+	while (used < count && (used == 0 || scanned + lists[used].length <= SUGGEST_SCAN_BUDGET)) {
+		uint32_t bucket = lists[used].bucket;
+
+		for (uint64_t entry = g->trigramOffsets[bucket]; entry < g->trigramOffsets[bucket + 1]; entry++) {
+			uint32_t actor = g->trigramActors[entry];
+
+			if (state->actorStamps[actor] != epoch) {
+				state->actorStamps[actor] = epoch;
+				state->levels[actor] = 0;
+				enqueue(&state->queue, actor);
+			}
+			state->levels[actor]++;
+		}
+		scanned += lists[used].length;
+		used++;
+	}
+
+	// Candidates were queued after a reset, so they sit at the start of the buffer.
+	// Order them by trigrams shared so far, most first (a counting sort)
+	size_t numCandidates = state->queue.count;
+	uint32_t *candidates = malloc((numCandidates + 1) * sizeof(uint32_t));
+	size_t *starts = calloc(used + 2, sizeof(size_t));
+
+	if (candidates == NULL || starts == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	for (size_t index = 0; index < numCandidates; index++) {
+		starts[used - state->levels[state->queue.items[index]] + 1]++;
+	}
+	for (uint32_t rank = 0; rank <= used; rank++) {
+		starts[rank + 1] += starts[rank];
+	}
+	for (size_t index = 0; index < numCandidates; index++) {
+		uint32_t actor = state->queue.items[index];
+		candidates[starts[used - state->levels[actor]]++] = actor;
+	}
+
+	// A candidate can share at most all the unscanned trigrams too, and similarity is
+	// at most shared / count, so once that bound cannot beat the k-th best or reach
+	// SUGGEST_MIN_SIMILARITY, no later candidate can either
+	uint32_t unscanned = count - used;
+	int found = 0;
+
+	for (size_t index = 0; index < numCandidates; index++) {
+		uint32_t actor = candidates[index];
+		int shared = state->levels[actor];
+		double bound = (double) (shared + unscanned) / count;
+
+		if (bound < SUGGEST_MIN_SIMILARITY || (found == k && bound <= scores[k - 1])) {
+			break;
+		}
+
+		// The same bound for this name's own trigram count is often much lower
+		int most = shared + unscanned < g->trigramCounts[actor] ? shared + unscanned : g->trigramCounts[actor];
+		bound = (double) most / (count + g->trigramCounts[actor] - most);
+
+		if (bound < SUGGEST_MIN_SIMILARITY || (found == k && bound <= scores[k - 1])) {
+			continue;
+		}
+
+		for (uint32_t list = used; list < count; list++) {
+			shared += listsActor(g, lists[list].bucket, actor);
+		}
+
+		double score = (double) shared / (count + g->trigramCounts[actor] - shared);
+
+		if (score < SUGGEST_MIN_SIMILARITY) {
+			continue;
+		}
+
+		// Keep the k best, ties going to the candidate seen first
+		int at = found < k ? found : k;
+		while (at > 0 && scores[at - 1] < score) {
+			at--;
+		}
+		if (at == k) {
+			continue;
+		}
+		int last = found < k ? found : k - 1;
+		memmove(ids + at + 1, ids + at, (last - at) * sizeof(uint32_t));
+		memmove(scores + at + 1, scores + at, (last - at) * sizeof(double));
+		ids[at] = actor;
+		scores[at] = score;
+		if (found < k) {
+			found++;
+		}
+	}
+
+	free(candidates);
+	free(starts);
+	free(folded);
+	free(buckets);
+	free(lists);
+	free(scores);
+	return found;
+}
+
+
+
+
+/*
+* bacon_open(path, threads) -- parses a movies file into a new graph.
+* path: pointer to a string containing the file's path.
+* threads: number of threads to parse with and to run full searches on, or 0
+*          for one per online CPU.
+* Returns: the graph, or NULL if the file could not be opened.
+* Assumptions: path is a valid, null-terminated string.
+* Side effects: allocates the graph; keeps the file mapped until bacon_close; records
+*               the size and the time of each loading step in its stats.
+*/
+bacon_graph* bacon_open(const char *path, int threads) {
+
+	struct bacon_graph *g = calloc(1, sizeof(struct bacon_graph));
+
+	if (g == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	g->threads = threads;
+	g->snapshotCenter = NO_ACTOR;
+
+	double start = clockSeconds();
+
+	if (loadInput(g, path) != 0) {
+		free(g);
+		return NULL;
+	}
+	pthread_mutex_init(&g->foldLock, NULL);
+	pthread_mutex_init(&g->bfsLock, NULL);
+
+	double loaded = clockSeconds();
+	parseFile(g);
+
+	double parsed = clockSeconds();
+	buildGraph(g);
+	labelComponents(g);
+
+	g->stats.bytesRead = g->nameBaseSize;
+	g->stats.loadSeconds = loaded - start;
+	g->stats.parseSeconds = parsed - loaded;
+	g->stats.buildSeconds = clockSeconds() - parsed;
+	return g;
+}
+
+
+
+/*
+* bacon_open_snapshot(path, threads) -- maps a binary snapshot as a new graph.
+* path: pointer to a string containing the snapshot's path.
+* threads: as for bacon_open.
+* Returns: the graph, or NULL if the file is missing or not a valid snapshot.
+* Assumptions: path is a valid, null-terminated string.
+* Side effects: allocates the graph and maps the snapshot until bacon_close; records
+*               its size and loading time in the graph's stats.
+*/
+bacon_graph* bacon_open_snapshot(const char *path, int threads) {
+
+	struct bacon_graph *g = calloc(1, sizeof(struct bacon_graph));
+
+	if (g == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	g->threads = threads;
+	g->snapshotCenter = NO_ACTOR;
+
+	double start = clockSeconds();
+
+	if (loadSnapshot(g, path) != 0) {
+		free(g);
+		return NULL;
+	}
+	pthread_mutex_init(&g->foldLock, NULL);
+	pthread_mutex_init(&g->bfsLock, NULL);
+
+	g->stats.bytesRead = g->snapshotSize;
+	g->stats.loadSeconds = clockSeconds() - start;
+	return g;
+}
+
+
+
+/*
+* bacon_close(graph) -- frees a graph.
+* graph: the graph, or NULL.
+* Returns: void.
+* Assumptions: every bacon_search opened on it has been closed.
+* Side effects: releases the label index, the name indexes, the graph, its input text
+*               and graph itself.
+*/
+void bacon_close(bacon_graph *graph) {
+	if (graph == NULL) {
+		return;
+	}
+	stopBFSPool(graph);
+	freeLabels(graph);
+	freeNameIndex(graph);
+	freeGraph(graph);
+	freeInput(graph);
+	pthread_mutex_destroy(&graph->foldLock);
+	pthread_mutex_destroy(&graph->bfsLock);
+	free(graph);
+}
+
+
+
+/*
+* bacon_search_open(graph) -- creates a search context for one thread.
+* graph: the graph to search.
+* Returns: the context.
+* Assumptions: graph was returned by bacon_open or bacon_open_snapshot.
+* Side effects: allocates two search states sized for graph.
+*/
+bacon_search* bacon_search_open(const bacon_graph *graph) {
+
+	struct bacon_search *search = calloc(1, sizeof(struct bacon_search));
+
+	if (search == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	initSearchState(graph, &search->forward);
+	initSearchState(graph, &search->backward);
+	return search;
+}
+
+
+
+/*
+* bacon_search_close(search) -- frees a search context.
+* search: the context, or NULL.
+* Returns: void.
+* Assumptions: none.
+* Side effects: deallocates the search states and the last path.
+*/
+void bacon_search_close(bacon_search *search) {
+	if (search == NULL) {
+		return;
+	}
+	freeSearchState(&search->forward);
+	freeSearchState(&search->backward);
+	free(search->links);
+	free(search);
+}
+
+
+
+/*
+* lookupPair(search, from, to, fromID, toID) -- resolves the two actor names of a query.
+* search: the calling thread's search context.
+* from: pointer to the null-terminated name of the first actor.
+* to: pointer to the null-terminated name of the second actor.
+* fromID: pointer to receive the ID of from.
+* toID: pointer to receive the ID of to.
+* Returns: 0 if both actors exist (by exact or folded name), BACON_NOT_FOUND otherwise.
+* Assumptions: none.
+* Side effects: none.
+*/
+int lookupPair(const bacon_search *search, const char *from, const char *to, uint32_t *fromID, uint32_t *toID) {
+
+	const struct bacon_graph *g = search->forward.graph;
+
+	*fromID = lookupActor(g, from, strlen(from));
+	*toID = lookupActor(g, to, strlen(to));
+
+	if (*fromID == NO_ACTOR || *toID == NO_ACTOR) {
+		return BACON_NOT_FOUND;
+	}
+	return 0;
+}
+
+
+
+/*
+* bacon_distance(search, from, to) -- computes the degrees of separation of two actors.
+* search: the calling thread's search context.
+* from: pointer to the null-terminated name of the first actor.
+* to: pointer to the null-terminated name of the second actor.
+* Returns: the number of movies in a shortest chain linking them (0 for the same
+*          actor), BACON_NO_CONNECTION or BACON_NOT_FOUND.
+* Assumptions: no other thread uses search.
+* Side effects: may run a bidirectional BFS on the search states of search.
+*/
+int bacon_distance(bacon_search *search, const char *from, const char *to) {
+
+	const struct bacon_graph *g = search->forward.graph;
+	uint32_t fromID, toID, meet;
+
+	if (lookupPair(search, from, to, &fromID, &toID) != 0) {
+		return BACON_NOT_FOUND;
+	}
+	if (g->components[fromID] != g->components[toID]) {
+		return BACON_NO_CONNECTION;
+	}
+	if (g->labelOffsets != NULL) {
+		return labelDistance(g, fromID, toID);
+	}
+	return BFS(&search->forward, &search->backward, fromID, toID, &meet);
+}
+
+
+
+/*
+* reserveLinks(search, count) -- makes room for a path or a list of names in a search context.
+* search: the search context.
+* count: number of links needed.
+* Returns: void.
+* Assumptions: none.
+* Side effects: grows search->links when it is smaller than count.
+*/
+void reserveLinks(bacon_search *search, size_t count) {
+
+	if (count <= search->linksCapacity) {
+		return;
+	}
+
+	bacon_link *grown = realloc(search->links, count * sizeof(bacon_link));
+
+	if (grown == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+	search->links = grown;
+	search->linksCapacity = count;
+}
+
+
+
+/*
+* setLink(search, index, actor, movie) -- fills one entry of the path returned by bacon_path.
+* search: the search context that owns the path.
+* index: position of the entry.
+* actor: ID of the entry's actor.
+* movie: ID of the movie shared with the next actor, or NO_ACTOR on the last entry.
+* Returns: void.
+* Assumptions: index is below search->linksCapacity.
+* Side effects: overwrites search->links[index].
+*/
+void setLink(bacon_search *search, int index, uint32_t actor, uint32_t movie) {
+
+	const struct bacon_graph *g = search->forward.graph;
+	bacon_link *link = &search->links[index];
+
+	link->actor = g->nameBase + g->actorNames[actor].offset;
+	link->actorLength = g->actorNames[actor].length;
+	link->movie = NULL;
+	link->movieLength = 0;
+
+	if (movie != NO_ACTOR) {
+		link->movie = g->nameBase + g->movieNames[movie].offset;
+		link->movieLength = g->movieNames[movie].length;
+	}
+}
+
+
+
+/*
+* bacon_path(search, from, to, links) -- finds a shortest chain of movies between two actors.
+* search: the calling thread's search context.
+* from: pointer to the null-terminated name of the first actor.
+* to: pointer to the null-terminated name of the second actor.
+* links: pointer that receives the path, from the first actor to the second.
+* Returns: the distance as for bacon_distance; links is only set when it is >= 0.
+* Assumptions: no other thread uses search.
+* Side effects: runs a bidirectional BFS on the search states of search and
+*               replaces the path it holds, growing its buffer as needed.
+*/
+int bacon_path(bacon_search *search, const char *from, const char *to, const bacon_link **links) {
+
+	const struct bacon_graph *g = search->forward.graph;
+	uint32_t fromID, toID, meet;
+
+	if (lookupPair(search, from, to, &fromID, &toID) != 0) {
+		return BACON_NOT_FOUND;
+	}
+	if (g->components[fromID] != g->components[toID]) {
+		return BACON_NO_CONNECTION;
+	}
+
+	int distance = BFS(&search->forward, &search->backward, fromID, toID, &meet);
+
+	if (distance < 0) {
+		return BACON_NO_CONNECTION;
+	}
+
+	reserveLinks(search, (size_t) distance + 1);
+
+	// Forward parents lead from meet back to from, so fill that half right to left
+	int half = search->forward.levels[meet];
+	uint32_t cur = meet;
+
+	for (int index = half; index > 0; index--) {
+		uint32_t parent = search->forward.parents[cur];
+		setLink(search, index - 1, parent, search->forward.parentMovies[cur]);
+		cur = parent;
+	}
+
+	// Backward parents lead from meet on to to
+	cur = meet;
+	for (int index = half; index < distance; index++) {
+		setLink(search, index, cur, search->backward.parentMovies[cur]);
+		cur = search->backward.parents[cur];
+	}
+	setLink(search, distance, toID, NO_ACTOR);
+
+	*links = search->links;
+	return distance;
+}
+
+
+
+
+/*
+* bacon_index_names(graph) -- builds the trigram index behind bacon_suggest.
+* graph: the graph.
+* Returns: void.
+* Assumptions: no bacon_search is in use on graph yet.
+* Side effects: allocates the index, about four bytes per byte of actor names.
+*/
+void bacon_index_names(bacon_graph *graph) {
+	if (graph->trigramOffsets == NULL) {
+		buildTrigrams(graph);
+	}
+}
+
+
+
+/*
+* bacon_suggest(search, name, k, names) -- finds the actor names closest to a name.
+* search: the calling thread's search context.
+* name: pointer to the null-terminated name, usually one that was not found.
+* k: largest number of names wanted.
+* names: pointer that receives the names, most similar first, as links whose movie is
+*        NULL; owned by search as for bacon_path.
+* Returns: the number of names, 0 if bacon_index_names was not called.
+* Assumptions: no other thread uses search.
+* Side effects: uses the search states of search as scratch space and replaces the
+*               links it holds.
+*/
+int bacon_suggest(bacon_search *search, const char *name, int k, const bacon_link **names) {
+
+	if (k < 1) {
+		return 0;
+	}
+
+	uint32_t *ids = malloc(k * sizeof(uint32_t));
+
+	if (ids == NULL) {
+		fprintf(stderr, "Not Enough Memory.\n");
+		exit(1);
+	}
+
+	int found = suggestActors(&search->forward, name, strlen(name), ids, k);
+
+	reserveLinks(search, found);
+	for (int index = 0; index < found; index++) {
+		setLink(search, index, ids[index], NO_ACTOR);
+	}
+	free(ids);
+
+	*names = search->links;
+	return found;
+}
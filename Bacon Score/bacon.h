@@ -0,0 +1,138 @@
+/*
+* File: bacon.h
+* Author: Chance Krueger
+*
+* Purpose:
+*   Public interface of the Bacon graph library. A bacon_graph is built once
+*   from a movies file (or mapped from a snapshot) and never changes after
+*   that, so any number of threads may query it at the same time. Every
+*   thread answers its queries through its own bacon_search, which holds the
+*   scratch state of one search at a time.
+*
+*   Example:
+*       bacon_graph *graph = bacon_open("movies.txt", 0);
+*       bacon_search *search = bacon_search_open(graph);
+*       int score = bacon_distance(search, "Tom Hanks", "Kevin Bacon");
+*       bacon_search_close(search);
+*       bacon_close(graph);
+*/
+
+#ifndef BACON_H
+#define BACON_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bacon_graph bacon_graph;
+typedef struct bacon_search bacon_search;
+
+// Returned by bacon_distance and bacon_path
+#define BACON_NO_CONNECTION (-1)   // both actors exist but no chain of movies links them
+#define BACON_NOT_FOUND (-2)       // an actor is not in the graph
+
+/*
+ * bacon_link -- One step of a connection path.
+ *
+ * Fields:
+ *   actor       - Name of the actor; not null-terminated.
+ *   actorLength - Length of actor in bytes.
+ *   movie       - Title of the movie this actor shares with the next link's actor,
+ *                 or NULL on the last link; not null-terminated.
+ *   movieLength - Length of movie in bytes.
+ */
+typedef struct bacon_link {
+	const char *actor;
+	size_t actorLength;
+	const char *movie;
+	size_t movieLength;
+} bacon_link;
+
+/*
+* bacon_open(path, threads) -- parses a movies file into a new graph.
+* path: pointer to a string containing the file's path.
+* threads: number of threads to parse with and to run full searches on, or 0
+*          for one per online CPU.
+* Returns: the graph, or NULL if the file could not be opened.
+*/
+bacon_graph* bacon_open(const char *path, int threads);
+
+/*
+* bacon_open_snapshot(path, threads) -- maps a binary snapshot written by BaconScore
+*                                       --save-snapshot as a new graph.
+* path: pointer to a string containing the snapshot's path.
+* threads: as for bacon_open.
+* Returns: the graph, or NULL if the file is missing or not a valid snapshot.
+*/
+bacon_graph* bacon_open_snapshot(const char *path, int threads);
+
+/*
+* bacon_close(graph) -- frees a graph.
+* graph: the graph, or NULL.
+* Assumptions: every bacon_search opened on it has been closed.
+*/
+void bacon_close(bacon_graph *graph);
+
+/*
+* bacon_search_open(graph) -- creates a search context for one thread.
+* graph: the graph to search.
+* Returns: the context; it must not be used by two threads at once.
+*/
+bacon_search* bacon_search_open(const bacon_graph *graph);
+
+/*
+* bacon_search_close(search) -- frees a search context.
+* search: the context, or NULL.
+*/
+void bacon_search_close(bacon_search *search);
+
+/*
+* bacon_distance(search, from, to) -- computes the degrees of separation of two actors.
+*                                     Names that match no actor exactly are looked up
+*                                     again ignoring case and extra whitespace.
+* search: the calling thread's search context.
+* from: pointer to the null-terminated name of the first actor.
+* to: pointer to the null-terminated name of the second actor.
+* Returns: the number of movies in a shortest chain linking them (0 for the same
+*          actor), BACON_NO_CONNECTION or BACON_NOT_FOUND.
+*/
+int bacon_distance(bacon_search *search, const char *from, const char *to);
+
+/*
+* bacon_path(search, from, to, links) -- finds a shortest chain of movies between two actors.
+* search: the calling thread's search context.
+* from: pointer to the null-terminated name of the first actor.
+* to: pointer to the null-terminated name of the second actor.
+* links: pointer that receives the path, from the first actor to the second: the
+*        returned distance plus one links, owned by search and valid until its next
+*        query or its closing.
+* Returns: the distance as for bacon_distance; links is only set when it is >= 0.
+*/
+int bacon_path(bacon_search *search, const char *from, const char *to, const bacon_link **links);
+
+/*
+* bacon_index_names(graph) -- builds the trigram index of actor names behind bacon_suggest.
+* graph: the graph.
+* Assumptions: no bacon_search is in use on graph yet.
+*/
+void bacon_index_names(bacon_graph *graph);
+
+/*
+* bacon_suggest(search, name, k, names) -- finds the actor names closest to a name,
+*                                          e.g. to offer for one that was not found.
+* search: the calling thread's search context.
+* name: pointer to the null-terminated name.
+* k: largest number of names wanted.
+* names: pointer that receives the names, most similar first, as links whose movie is
+*        NULL; owned by search as for bacon_path.
+* Returns: the number of names, 0 if bacon_index_names was not called.
+*/
+int bacon_suggest(bacon_search *search, const char *name, int k, const bacon_link **names);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,478 @@
+/*
+* File: bacon_internal.h
+* Author: Chance Krueger
+*
+* Purpose:
+*   Data structures of the Bacon graph library and the functions BaconScore
+*   builds its command line tools on. Programs that only need distances and
+*   paths should include bacon.h instead.
+*/
+
+#ifndef BACON_INTERNAL_H
+#define BACON_INTERNAL_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "bacon.h"
+
+
+
+/*
+ * nameRef -- A view of an actor or movie name inside the input text.
+ *
+ * Fields:
+ *   offset - Byte offset of the name from nameBase.
+ *   length - Length of the name in bytes; names are not null-terminated.
+ */
+struct nameRef {
+	uint64_t offset;
+	uint32_t length;
+};
+
+
+
+/*
+ * appearance -- One (actor, movie) edge recorded while parsing, before the
+ *               graph is finalized into CSR form by buildGraph.
+ *
+ * Fields:
+ *   actor - ID of the actor.
+ *   movie - ID of the movie the actor appears in.
+ */
+struct appearance {
+	uint32_t actor;
+	uint32_t movie;
+};
+
+
+
+/*
+ * castEntry -- One actor line found by a parse worker, waiting to be interned.
+ *
+ * Fields:
+ *   name  - View of the actor's name inside nameBase.
+ *   hash  - hashName of the name, computed by the worker.
+ *   movie - Index of the movie in the worker's own chunk.
+ */
+struct castEntry {
+	struct nameRef name;
+	uint64_t hash;
+	uint32_t movie;
+};
+
+
+
+/*
+ * parseChunk -- A byte range of the input parsed by one worker thread.
+ *
+ * Fields:
+ *   base          - Start of the input text, which name offsets count from.
+ *   begin         - First byte of the range; always the start of a movie line,
+ *                   except for the first chunk.
+ *   end           - One past the last byte of the range.
+ *   movies        - Titles of the movies in the range, in order.
+ *   numMovies     - Number of entries in movies.
+ *   cast          - Actor lines in the range, in order.
+ *   numCast       - Number of entries in cast.
+ *   moviesCapacity, castCapacity - Allocated sizes of the two arrays.
+ *   numLines      - Lines in the range, blank ones included.
+ */
+struct parseChunk {
+	const char *base;
+	const char *begin;
+	const char *end;
+	struct nameRef *movies;
+	uint32_t numMovies;
+	uint32_t moviesCapacity;
+	struct castEntry *cast;
+	size_t numCast;
+	size_t castCapacity;
+	uint64_t numLines;
+};
+
+
+
+/*
+ * csrGraph -- Finalized bipartite actor/movie graph in compressed sparse row form.
+ *
+ * Fields:
+ *   numActors    - Number of actors (IDs 0 .. numActors - 1, indexes into actorNames).
+ *   numMovies    - Number of movies (IDs 0 .. numMovies - 1, indexes into movieNames).
+ *   numEdges     - Number of distinct (actor, movie) appearances.
+ *   actorOffsets - numActors + 1 offsets; the movies of actor a are
+ *                  actorMovies[actorOffsets[a] .. actorOffsets[a + 1]).
+ *   actorMovies  - Movie IDs, grouped by actor.
+ *   movieOffsets - numMovies + 1 offsets; the cast of movie m is
+ *                  movieActors[movieOffsets[m] .. movieOffsets[m + 1]).
+ *   movieActors  - Actor IDs, grouped by movie.
+ */
+struct csrGraph {
+	uint32_t numActors;
+	uint32_t numMovies;
+	uint32_t numEdges;
+	uint32_t *actorOffsets;
+	uint32_t *actorMovies;
+	uint32_t *movieOffsets;
+	uint32_t *movieActors;
+};
+
+
+/*
+ * snapshotHeader -- Fixed header at the start of a binary graph snapshot.
+ *
+ * Every section is stored in native byte order at an 8-byte aligned offset from
+ * the start of the file, so a loaded snapshot is used in place without parsing.
+ *
+ * Fields:
+ *   magic          - SNAPSHOT_MAGIC.
+ *   version        - SNAPSHOT_VERSION; bumped whenever the layout changes.
+ *   flags          - SNAPSHOT_HAS_BACON when the Bacon table sections are present.
+ *   numActors      - Number of actors.
+ *   numMovies      - Number of movies.
+ *   numEdges       - Number of appearances.
+ *   bacon          - Actor ID of the center the Bacon table is for, or NO_ACTOR.
+ *   slotsCapacity  - Number of slots in the actor hash table.
+ *   namesSize      - Size in bytes of the name text section.
+ *   sections       - File offsets of the SNAPSHOT_SECTIONS sections, in the order
+ *                    of the snapshotSection enum.
+ */
+struct snapshotHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint32_t numActors;
+	uint32_t numMovies;
+	uint32_t numEdges;
+	uint32_t bacon;
+	uint64_t slotsCapacity;
+	uint64_t namesSize;
+	uint64_t sections[12];
+};
+
+enum snapshotSection {
+	SECTION_NAMES, SECTION_ACTOR_NAMES, SECTION_MOVIE_NAMES,
+	SECTION_ACTOR_OFFSETS, SECTION_ACTOR_MOVIES, SECTION_MOVIE_OFFSETS, SECTION_MOVIE_ACTORS,
+	SECTION_ACTOR_SLOTS, SECTION_BACON_DISTANCES, SECTION_BACON_PARENTS, SECTION_BACON_PARENT_MOVIES,
+	SECTION_COMPONENTS, SNAPSHOT_SECTIONS
+};
+
+#define SNAPSHOT_MAGIC "BACONSNP"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_HAS_BACON 1
+
+
+/*
+ * labelIndexHeader -- Fixed header at the start of a pruned landmark label file.
+ *
+ * The header is followed by numActors + 1 uint64 label offsets, numEntries uint32
+ * hubs padded to 8 bytes, then numEntries uint8 distances, all in native byte order.
+ *
+ * Fields:
+ *   magic      - LABEL_MAGIC.
+ *   version    - LABEL_VERSION; bumped whenever the layout changes.
+ *   numActors  - Number of actors of the graph the labels were built for.
+ *   graphHash  - graphHash() of that graph, so a stale file is rebuilt instead of used.
+ *   numEntries - Total number of label entries.
+ */
+struct labelIndexHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t numActors;
+	uint64_t graphHash;
+	uint64_t numEntries;
+};
+
+#define LABEL_MAGIC "BACONPLL"
+#define LABEL_VERSION 1
+
+// Label distances are stored in a byte; UINT8_MAX marks "no label" while building
+#define LABEL_MAX_DISTANCE (UINT8_MAX - 1)
+
+
+/*
+* queue -- growable ring buffer of actor IDs used as the BFS frontier.
+* items: circular array of actor IDs.
+* capacity: number of entries in items, always zero or a power of two.
+* head: index of the front entry.
+* count: number of queued entries.
+*/
+struct queue {
+        uint32_t *items;
+        size_t capacity;
+        size_t head;
+        size_t count;
+};
+
+
+
+/*
+ * arenaBlock -- Header at the start of one mmap'd chunk of an arena.
+ *
+ * Fields:
+ *   next - Pointer to the previously mapped block of the same arena.
+ *   size - Size of the whole mapping in bytes, header included.
+ */
+struct arenaBlock {
+	struct arenaBlock *next;
+	size_t size;
+};
+
+
+
+/*
+ * arena -- Bump-pointer allocator; everything in it is released at once.
+ *
+ * Fields:
+ *   blocks - Pointer to the most recently mapped block.
+ *   cursor - Next free byte in the current block.
+ *   end    - One past the last usable byte of the current block.
+ */
+struct arena {
+	struct arenaBlock *blocks;
+	char *cursor;
+	char *end;
+};
+
+#define ARENA_BLOCK_SIZE (4 * 1024 * 1024)
+
+
+
+/*
+ * searchState -- Reusable scratch state for one BFS over the graph.
+ *
+ * Fields:
+ *   graph        - The graph the state was sized for.
+ *   epoch        - Generation of the current search. An actor or movie has been
+ *                  visited by it when its stamp equals epoch, so starting a search
+ *                  is a counter bump instead of a clear.
+ *   actorStamps  - Per-actor visit stamps.
+ *   movieStamps  - Per-movie visit stamps; a stamped movie's cast has been expanded.
+ *   movieParents - Per-movie ID of the actor it was reached through (full searches only).
+ *   levels       - Per-actor distance from the source, valid for stamped actors.
+ *   parents      - Per-actor ID of the actor it was reached through.
+ *   parentMovies - Per-actor ID of the movie shared with that parent.
+ *   queue        - Frontier, sized for the whole graph once and reused.
+ *   actorsTouched, moviesTouched - Actors reached and movies expanded by pair
+ *                  searches on this state so far, for --stats.
+ */
+struct searchState {
+	const struct bacon_graph *graph;
+	uint32_t epoch;
+	uint32_t *actorStamps;
+	uint32_t *movieStamps;
+	uint32_t *movieParents;
+	int *levels;
+	uint32_t *parents;
+	uint32_t *parentMovies;
+	struct queue queue;
+	uint64_t actorsTouched;
+	uint64_t moviesTouched;
+};
+
+
+
+/*
+ * centerStats -- Summary of one full BFS from a center actor.
+ *
+ * Fields:
+ *   reachable     - Number of other actors connected to the center.
+ *   totalDistance - Sum of their distances from the center.
+ *   eccentricity  - Largest of those distances.
+ */
+struct centerStats {
+	uint64_t reachable;
+	uint64_t totalDistance;
+	uint32_t eccentricity;
+};
+
+// Sources searched together by multiSourceBFS: one bit each across MSBFS_WORDS words
+#define MSBFS_WORDS 4
+#define MSBFS_WIDTH (64 * MSBFS_WORDS)
+
+
+// Open-addressing (linear probing) hash table of actor IDs keyed by name
+#define EMPTY_SLOT UINT32_MAX
+#define NO_ACTOR UINT32_MAX
+
+
+
+/*
+ * loadStats -- What loading a graph took, for --stats.
+ *
+ * Fields:
+ *   bytesRead    - Size of the input text or snapshot.
+ *   lines        - Input lines scanned by parseFile (0 for a snapshot).
+ *   loadSeconds  - Time to map or read the input or snapshot.
+ *   parseSeconds - Time spent in parseFile.
+ *   buildSeconds - Time spent in buildGraph and labelComponents.
+ */
+struct loadStats {
+	uint64_t bytesRead;
+	uint64_t lines;
+	double loadSeconds;
+	double parseSeconds;
+	double buildSeconds;
+};
+
+
+
+// Threads of the parallel full BFS, private to bacon.c
+struct bfsPool;
+
+/*
+ * bacon_graph -- Everything loaded for one movies file or snapshot.
+ *
+ * Only bacon_open and bacon_open_snapshot (and the label index functions) write
+ * to it; afterwards it is read-only and may be searched by many threads.
+ *
+ * Fields:
+ *   nameBase, nameBaseSize - Input text that every nameRef points into, either
+ *                            mmap'd (nameBaseMapped) or read into memory.
+ *   actorNames     - Actor IDs -> name, in parse order.
+ *   numActors, actorsCapacity - Actors interned so far and allocated entries.
+ *   movieNames     - Movie IDs -> title, in parse order.
+ *   numMovies, moviesCapacity - Movies created so far and allocated entries.
+ *   threads        - Threads for parsing and full searches (0 = one per online CPU).
+ *   arena          - Owns the finalized graph arrays.
+ *   snapshotMap, snapshotSize - Snapshot file the tables point into, if any.
+ *   snapshotCenter - Center whose table the snapshot holds, or NO_ACTOR.
+ *   snapshotDistances, snapshotParents, snapshotParentMovies - That table.
+ *   labelOffsets   - Pruned landmark labels: actor a's label is entries
+ *                    [labelOffsets[a], labelOffsets[a + 1]) of labelHubs (hub ranks,
+ *                    ascending) and labelDistances (a's distance to each hub).
+ *                    NULL when no index is in use.
+ *   labelMap, labelMapSize - Label file the label arrays point into, if any.
+ *   appearances    - Edges gathered by parseFile, consumed by buildGraph.
+ *   numAppearances, appearancesCapacity - Used and allocated entries.
+ *   csr            - Finalized graph.
+ *   components     - Connected component of every actor, named by one of its
+ *                    actors; two actors are connected exactly when these match.
+ *   actorSlots, actorSlotsCapacity - Hash table of actor IDs keyed by name.
+ *   stats          - Sizes and timings of the load.
+ *   foldSlots, foldSlotsCapacity - Hash table of actor IDs keyed by folded name
+ *                    (see foldName), for lookups that ignore case and spacing.
+ *                    Built by the first lookup that misses; NULL until then.
+ *   foldLock, foldReady - Let exactly one thread build foldSlots; foldReady is set,
+ *                    with release order, once it is complete.
+ *   bfsLock        - Held by BFSAll for a whole search, so searches share bfsPool.
+ *   bfsPool        - Threads of the parallel full BFS, started by the first BFSAll
+ *                    and stopped by bacon_close; NULL until then.
+ *   trigramBits    - log2 of the number of trigram buckets.
+ *   trigramOffsets - Trigram index: bucket b lists the actors
+ *                    trigramActors[trigramOffsets[b] .. trigramOffsets[b + 1]), in
+ *                    increasing ID order. NULL unless buildTrigrams has run.
+ *   trigramCounts  - Per-actor number of distinct trigram buckets (at most 65535).
+ */
+struct bacon_graph {
+	const char *nameBase;
+	size_t nameBaseSize;
+	int nameBaseMapped;
+	struct nameRef *actorNames;
+	uint32_t numActors;
+	uint32_t actorsCapacity;
+	struct nameRef *movieNames;
+	uint32_t numMovies;
+	uint32_t moviesCapacity;
+	long threads;
+	struct arena arena;
+	void *snapshotMap;
+	size_t snapshotSize;
+	uint32_t snapshotCenter;
+	int *snapshotDistances;
+	uint32_t *snapshotParents;
+	uint32_t *snapshotParentMovies;
+	uint64_t *labelOffsets;
+	uint32_t *labelHubs;
+	uint8_t *labelDistances;
+	void *labelMap;
+	size_t labelMapSize;
+	struct appearance *appearances;
+	size_t numAppearances;
+	size_t appearancesCapacity;
+	struct csrGraph csr;
+	uint32_t *components;
+	uint32_t *actorSlots;
+	size_t actorSlotsCapacity;
+	struct loadStats stats;
+	uint32_t *foldSlots;
+	size_t foldSlotsCapacity;
+	pthread_mutex_t foldLock;
+	int foldReady;
+	pthread_mutex_t bfsLock;
+	struct bfsPool *bfsPool;
+	int trigramBits;
+	uint64_t *trigramOffsets;
+	uint32_t *trigramActors;
+	uint16_t *trigramCounts;
+};
+
+/*
+ * bacon_search -- A thread's search context for the public API.
+ *
+ * Fields:
+ *   forward, backward - The two halves of a bidirectional search.
+ *   links             - Path returned by the last bacon_path call.
+ *   linksCapacity     - Allocated entries in links.
+ */
+struct bacon_search {
+	struct searchState forward;
+	struct searchState backward;
+	bacon_link *links;
+	size_t linksCapacity;
+};
+
+
+
+// Monotonic clock in seconds, for timings
+double clockSeconds();
+
+// Loading, one step at a time (bacon_open runs them in this order)
+int loadInput(struct bacon_graph *g, const char *path);
+void parseFile(struct bacon_graph *g);
+void buildGraph(struct bacon_graph *g);
+void labelComponents(struct bacon_graph *g);
+void freeGraph(struct bacon_graph *g);
+void freeInput(struct bacon_graph *g);
+
+// Names and lookups
+void printName(const struct bacon_graph *g, FILE *out, struct nameRef name);
+uint64_t hashName(const char *name, size_t length);
+uint32_t findActor(const struct bacon_graph *g, const char *actor, size_t length);
+size_t foldName(const char *name, size_t length, char *out);
+void indexFoldedNames(struct bacon_graph *g);
+uint32_t lookupActor(const struct bacon_graph *g, const char *actor, size_t length);
+void buildTrigrams(struct bacon_graph *g);
+void freeNameIndex(struct bacon_graph *g);
+int suggestActors(struct searchState *state, const char *name, size_t length, uint32_t *ids, int k);
+void printActorsWithMovies(const struct bacon_graph *g);
+
+// Snapshots and the label index
+int saveSnapshot(const struct bacon_graph *g, const char *path, uint32_t center, const int *distances,
+		const uint32_t *parents, const uint32_t *parentMovies);
+int buildLabels(struct bacon_graph *g);
+int saveLabels(const struct bacon_graph *g, const char *path);
+int loadLabels(struct bacon_graph *g, const char *path);
+void freeLabels(struct bacon_graph *g);
+int labelDistance(const struct bacon_graph *g, uint32_t from, uint32_t to);
+
+// Searches
+void initSearchState(const struct bacon_graph *g, struct searchState *state);
+void freeSearchState(struct searchState *state);
+int BFS(struct searchState *forward, struct searchState *backward, uint32_t start, uint32_t target,
+		uint32_t *meet);
+void BFSAll(struct searchState *state, uint32_t start, int *distances, uint32_t *parents,
+		uint32_t *parentMovies);
+void stopBFSPool(struct bacon_graph *g);
+void multiSourceBFS(const struct bacon_graph *g, const uint32_t *sources, uint32_t count,
+		struct centerStats *stats);
+
+// Connection paths
+void printPath(const struct bacon_graph *g, FILE *out, uint32_t from, uint32_t to,
+		const uint32_t *parents, const uint32_t *parentMovies);
+void printPairPath(FILE *out, const struct searchState *forward, const struct searchState *backward,
+		uint32_t target, uint32_t meet);
+
+#endif
@@ -0,0 +1,34 @@
+/*
+* File: bacon_random.h
+* Author: Chance Krueger
+*
+* Purpose:
+*   The pseudo-random generator shared by BaconGenerate and BaconBench, so the
+*   benchmark samples its queries with exactly the generator that built its
+*   input files.
+*/
+
+#ifndef BACON_RANDOM_H
+#define BACON_RANDOM_H
+
+#include <stdint.h>
+
+
+
+/*
+* nextRandom(state) -- advances a splitmix64 generator.
+* state: pointer to the generator state.
+* Returns: the next 64 pseudo-random bits.
+* Assumptions: none.
+* Side effects: updates *state.
+*/
+static inline uint64_t nextRandom(uint64_t *state) {
+
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+#endif